@@ -0,0 +1,10 @@
+/*
+ * Critterbits build of duktape with the interrupt counter turned on. The exec timeout check runs every so many
+ * bytecode instructions and is used by the engine's script profiler to take samples, it never times anything out.
+ */
+#define DUK_OPT_INTERRUPT_COUNTER
+#define DUK_OPT_EXEC_TIMEOUT_CHECK(udata) critterbits_duktape_interrupt((udata))
+
+extern int critterbits_duktape_interrupt(void * udata);
+
+#include "duktape.c"
\ No newline at end of file
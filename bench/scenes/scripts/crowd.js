@@ -0,0 +1,36 @@
+// declare module
+var crowd = (function() {
+var cm = {};
+
+// 2000 elk on a 50x40 grid, 64px apart so no two colliders overlap
+var COLUMNS = 50;
+var ROWS = 40;
+var SPACING = 64;
+
+var spawned = false;
+
+// the whole crowd is queued on the first update and then left alone
+cm.update = function(dt) {
+    if (spawned) {
+        return;
+    }
+    spawned = true;
+    var points = [];
+    for (var y = 0; y < ROWS; y++) {
+        for (var x = 0; x < COLUMNS; x++) {
+            points.push({ "x": x * SPACING, "y": y * SPACING });
+        }
+    }
+    if (typeof spawn_many === "function") {
+        spawn_many("still_elk", points);
+    } else {
+        // engines without spawn_many
+        for (var i = 0; i < points.length; i++) {
+            spawn("still_elk", points[i]);
+        }
+    }
+}
+
+// end module
+return cm;
+}());
\ No newline at end of file
@@ -0,0 +1,39 @@
+// declare module
+var spawner = (function() {
+var sm = {};
+
+// elk spawned per update, spread over a 3200x2560 area in 16px cells
+var BATCH = 50;
+var COLUMNS = 200;
+var CELLS = 200 * 160;
+
+// updates so far, which the elk use to time their own lifetime
+sm.ticks = 0;
+
+// stepping through the cells by a prime visits every cell once before repeating, so live elk never share a cell
+var spawned = 0;
+var next_point = function() {
+    var cell = (spawned * 7919) % CELLS;
+    spawned++;
+    return { "x": (cell % COLUMNS) * 16, "y": Math.floor(cell / COLUMNS) * 16 };
+};
+
+sm.update = function(dt) {
+    sm.ticks++;
+    var points = [];
+    for (var i = 0; i < BATCH; i++) {
+        points.push(next_point());
+    }
+    if (typeof spawn_many === "function") {
+        spawn_many("spawned_elk", points);
+    } else {
+        // engines without spawn_many
+        for (var i = 0; i < points.length; i++) {
+            spawn("spawned_elk", points[i]);
+        }
+    }
+}
+
+// end module
+return sm;
+}());
\ No newline at end of file
@@ -0,0 +1,31 @@
+// declare module
+var spawned_elk = (function() {
+var em = {};
+
+// each elk lives for 60 updates, so the scene settles at about 3000 of them
+var LIFETIME = 60;
+
+// spawn tick per elk, keyed by position since no two live elk share one. This uses the scene's update count rather
+// than delay(), so the timing doesn't depend on how the engine drives callbacks.
+var born = {};
+
+var key = function(entity) {
+    return entity.pos.x + "," + entity.pos.y;
+};
+
+em.start = function() {
+    born[key(this)] = spawner.ticks;
+    this.animation.play("walk_down");
+}
+
+em.update = function(dt) {
+    var k = key(this);
+    if (spawner.ticks - born[k] >= LIFETIME) {
+        delete born[k];
+        this.destroy();
+    }
+}
+
+// end module
+return em;
+}());
\ No newline at end of file
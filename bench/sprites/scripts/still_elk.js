@@ -0,0 +1,12 @@
+// declare module
+var still_elk = (function() {
+var em = {};
+
+// still elk stand in place and animate, so a frame is mostly the engine's own entity passes
+em.start = function() {
+    this.animation.play("walk_down");
+}
+
+// end module
+return em;
+}());
\ No newline at end of file
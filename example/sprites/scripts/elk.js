@@ -22,10 +22,6 @@ em.start = function() {
     callback.call(this);
 }
 
-//FIXME: callbacks don't get called if there's no update function
-em.update = function(dt) {
-}
-
 // end module
 return em;
 }());
\ No newline at end of file
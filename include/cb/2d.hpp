@@ -28,6 +28,10 @@ inline CB_Point QuadEaseIn2D(const CB_Point & start, const CB_Point & end, float
   return (end - start) * percent * percent + start;
 }	
 
+/*
+ * Replaces a set of rects with a set of non-overlapping rects covering the same area, merging runs of neighbouring
+ * rects (e.g. solid map tiles) into as few larger ones as it reasonably can.
+ */
 class RectRegionCombiner {
   public:
     std::vector<CB_Rect> regions;
@@ -22,6 +22,8 @@ typedef struct KeyFrame {
         : property(property), value(value), duration(duration){};
 } KeyFrame;
 
+typedef std::vector<KeyFrame> KeyFrameList;
+
 class Animation {
   public:
     std::string name;
@@ -29,6 +31,7 @@ class Animation {
 
     Animation(const std::string & name) : name(name), loop(false){};
     virtual void Animate(std::shared_ptr<Entity>, float) = 0;
+    virtual bool CanAnimateConcurrently() const { return false; };
     bool IsDestroyed() { return this->state == AnimationState::Destroyed; };
     bool IsPlaying() { return this->state == AnimationState::Playing; };
     void Pause();
@@ -48,19 +51,21 @@ class Animation {
 
 class KeyFrameAnimation : public Animation {
   public:
-    KeyFrameAnimation(const std::string & name) : Animation(name){};
-    void AddKeyFrame(const KeyFrame & key_frame);
+    // key frames are shared between every sprite instantiated from the same prefab
+    KeyFrameAnimation(const std::string & name, std::shared_ptr<const KeyFrameList> key_frames)
+        : Animation(name), key_frames(std::move(key_frames)){};
     void Animate(std::shared_ptr<Entity>, float);
+    // only touches the animated sprite's own frame/flip state, so sprites can be ticked on worker threads
+    bool CanAnimateConcurrently() const { return true; };
 
   protected:
     void OnStop();
 
   private:
     int next_key_frame{0};
-    int key_frame_count{0};
     float key_frame_delta{0.f};
     float next_key_frame_at{0.f};
-    std::vector<KeyFrame> key_frames{};
+    std::shared_ptr<const KeyFrameList> key_frames;
 
     void AnimateKeyFrame(std::shared_ptr<Entity>, const KeyFrame &);
 };
@@ -4,7 +4,7 @@
 namespace Critterbits{
 namespace AssetPack {
 
-#define CB_ASSETPACK_VER_MAJ 1
+#define CB_ASSETPACK_VER_MAJ 3
 #define CB_ASSETPACK_VER_MIN 0
 #define CB_ASSETPACK_HDR_BYTES 0xef, 0xbb, 0xbf, 'c', 'b', 'p', 'a', 'k', 0xe2, 0x90, 0x84, 0
 #define CB_ASSETPACK_MAX_NAME_SIZE 256
@@ -12,6 +12,11 @@ namespace AssetPack {
 #define CB_ASSETPACK_FLAGS_NONE 0
 #define CB_ASSETPACK_FLAGS_COMPRESSED 1
 
+#define CB_ASSETPACK_FORMAT_RAW 0
+#define CB_ASSETPACK_FORMAT_SCRIPT_BYTECODE 1
+// precompiled scripts are stored next to their source under the source name plus this suffix
+#define CB_ASSETPACK_BYTECODE_SUFFIX ".bc"
+
 typedef struct CB_AssetPackHeader {
 #ifdef _MSC_VER
 	CB_AssetPackHeader() {};
@@ -29,8 +34,22 @@ typedef struct CB_AssetDictEntry {
     char name[CB_ASSETPACK_MAX_NAME_SIZE];
     unsigned long pos{0L};
     unsigned long length{0L};
+    unsigned int format{CB_ASSETPACK_FORMAT_RAW};
+    // for script bytecode, the DUK_VERSION of the compiler that produced it
+    unsigned long format_version{0L};
+    // for script bytecode, Checksum() of the entry's bytes
+    unsigned long checksum{0L};
 } CB_AssetDictEntry;
 
+// 32-bit FNV-1a, enough to catch a damaged or truncated entry (not a deliberately altered one)
+inline unsigned long Checksum(const char * data, unsigned long length) {
+    unsigned long hash = 2166136261UL;
+    for (unsigned long i = 0; i < length; i++) {
+        hash = ((hash ^ static_cast<unsigned char>(data[i])) * 16777619UL) & 0xffffffffUL;
+    }
+    return hash;
+}
+
 }
 }
 #endif
\ No newline at end of file
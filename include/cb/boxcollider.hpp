@@ -2,31 +2,80 @@
 #ifndef CBBOXCOLLIDER_HPP
 #define CBBOXCOLLIDER_HPP
 
+#include <unordered_map>
 #include <vector>
 
 #include "coord.hpp"
 #include "entity.hpp"
 
+#define CB_COLLIDER_GRID_CELL_SIZE 64
+
 namespace Critterbits {
 enum class CollisionType { None, Collide, Trigger };
 
+class ColliderGrid;
+class Tilemap;
+
 class BoxCollider : public Entity {
+    friend class ColliderGrid;
+
   public:
     CollisionType collision{CollisionType::None};
     CB_Rect collision_box;
 
     BoxCollider(){};
-    ~BoxCollider(){};
+    ~BoxCollider();
     CB_Rect GetCollisionRect() const;
     CB_Point GetValidPosition(int, int, int, int);
+    static void ResolveCollision(const std::shared_ptr<Entity> &, const std::shared_ptr<Entity> &);
     virtual void SetPosition(int, int) = 0;
 
+  protected:
+    void UpdateGridPosition();
+
   private:
+    ColliderGrid * collider_grid{nullptr};
+    CB_Rect collider_grid_cells;
     std::vector<entity_id_t> is_colliding_with;
 
     bool IsCollidingWith(entity_id_t);
-    void NotifyCollision(std::weak_ptr<BoxCollider>);
+    void NotifyCollision(BoxCollider *);
     void RemoveCollisionWith(entity_id_t);
+    bool TestCollision(BoxCollider *, int, int, CB_Rect *);
+    bool TestMapCollision(Tilemap &, size_t, int, int, CB_Rect *, entity_id_t *);
+};
+
+/*
+ * Uniform grid broadphase for colliders. Each collider is bucketed into every cell its collision rect overlaps,
+ * so a query only has to look at colliders sharing a cell with the rect being tested.
+ */
+class ColliderGrid {
+  public:
+    ColliderGrid(int cell_size = CB_COLLIDER_GRID_CELL_SIZE) : cell_size(cell_size){};
+    ~ColliderGrid();
+    void Clear();
+    size_t GetColliderCount() const { return this->collider_count; };
+    void Insert(BoxCollider *);
+    void InsertAll(const std::vector<BoxCollider *> &, bool = false);
+    void Move(BoxCollider *);
+    void Query(const CB_Rect &, std::vector<BoxCollider *> *) const;
+    void Remove(BoxCollider *);
+
+  private:
+    typedef unsigned long long cell_key_t;
+
+    int cell_size;
+    size_t collider_count{0};
+    std::unordered_map<cell_key_t, std::vector<BoxCollider *>> cells;
+
+    ColliderGrid(const ColliderGrid &) = delete;
+    ColliderGrid(ColliderGrid &&) = delete;
+    void AddToCells(BoxCollider *, const CB_Rect &);
+    CB_Rect GetCellRange(const CB_Rect &) const;
+    static cell_key_t GetCellKey(int x, int y) {
+        return (static_cast<cell_key_t>(static_cast<unsigned int>(x)) << 32) | static_cast<unsigned int>(y);
+    };
+    void RemoveFromCells(BoxCollider *, const CB_Rect &);
 };
 }
 #endif
\ No newline at end of file
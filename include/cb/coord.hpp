@@ -86,6 +86,8 @@ class FlexRect {
 
 enum class ZIndex { Background, Midground, Foreground, Gui };
 
+inline unsigned int ZIndexMask(ZIndex z_index) { return 1u << static_cast<unsigned int>(z_index); }
+
 typedef struct CB_ViewClippingInfo {
     CB_Rect source{}, dest{};
     ZIndex z_index{ZIndex::Midground};
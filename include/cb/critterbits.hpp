@@ -12,13 +12,17 @@
 #include "assetpack.hpp"
 #include "resource.hpp"
 #include "input.hpp"
+#include "jobs.hpp"
 #include "logging.hpp"
 #include "math.hpp"
+#include "profiler.hpp"
+#include "render.hpp"
 #include "scene.hpp"
 #include "sdl.hpp"
 #include "anim.hpp"
 #include "sprite.hpp"
 #include "tilemap.hpp"
+#include "timers.hpp"
 #include "viewport.hpp"
 #include "toml.hpp"
 #include "gui.hpp"
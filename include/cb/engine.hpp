@@ -5,6 +5,7 @@
 #include <SDL.h>
 #include <functional>
 #include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -13,7 +14,10 @@
 #include "boxcollider.hpp"
 #include "sprite.hpp"
 #include "input.hpp"
+#include "jobs.hpp"
+#include "render.hpp"
 #include "scene.hpp"
+#include "timers.hpp"
 #include "viewport.hpp"
 #include "gui.hpp"
 #include "scripting/scripting.hpp"
@@ -24,21 +28,30 @@
 #define CB_CONFIG_FILE "cbconfig.toml"
 #define CB_DEFAULT_ASSET_PATH "./assets"
 #define CB_DESIRED_UPS 60.0f
+#define CB_TIMING_SAMPLE_COUNT 300
 
 namespace Critterbits {
-template<class T>
-using EntityIterateFunction = std::function<bool(std::shared_ptr<T>)>;
-
 class EngineConfiguration {
   public:
     std::string asset_path;
+    std::string first_scene{CB_FIRST_SCENE};
     std::shared_ptr<ResourceLoader> loader;
     struct {
         bool draw_gui_rects{false};
         bool draw_info_pane{false};
         bool draw_map_regions{false};
         bool draw_sprite_rects{false};
+        bool profile{false};
+        bool profile_entities{false};
+        bool profile_script_sampling{false};
+        bool profile_scripts{false};
     } debug;
+    struct {
+        bool enabled{false};
+        bool realtime{false};
+        bool render{true};
+        unsigned int ticks{0};
+    } headless;
     struct {
         bool controller{false};
         bool keyboard{true};
@@ -47,6 +60,16 @@ class EngineConfiguration {
     struct {
         float scale{1.0f};
     } rendering;
+    struct {
+        int heap_limit_kb{0};
+    } scripting;
+    struct {
+        bool parallel_animation{true};
+        bool parallel_colliders{true};
+        bool parallel_culling{true};
+        bool parallel_tilemap{true};
+        int workers{-1};
+    } threading;
     struct {
         bool full_screen{false};
         int width{CB_DEFAULT_WINDOW_W};
@@ -68,33 +91,94 @@ class EngineConfiguration {
     std::string GetExpandedPath(const std::string &);
 };
 
+/*
+ * Rolling window of the most recent timing samples (in milliseconds), used for percentiles.
+ */
+class TimingSamples {
+  public:
+    struct Stats {
+        float p50{0.f};
+        float p95{0.f};
+        float p99{0.f};
+        float max{0.f};
+    };
+
+    TimingSamples() { this->Reset(); };
+    void AddSample(float);
+    float GetMean() const;
+    Stats GetStats() const;
+    void Reset();
+
+  private:
+    float samples[CB_TIMING_SAMPLE_COUNT];
+    size_t count;
+    size_t next;
+};
+
 class EngineCounters {
   public:
     EngineCounters() { this->Reset(); };
 
-    void CountedEntity();
-    float GetAverageFps() { return this->fps; };
+    void CountedEntity(unsigned int = 1);
+    void ExecutedEvents(unsigned int);
+    float GetAverageFps() const;
+    unsigned int GetCollisionPairsTestedCount() { return this->collision_pair_count; };
     float GetDeltaFromRemainingFrameTime();
     float GetDeltaTime() { return this->delta_time; };
-    unsigned int GetRemainingFrameTime() { return this->frame_time; };
+    unsigned int GetExecutedEventCount() { return this->executed_event_count; };
+    TimingSamples::Stats GetFrameTimeStats() const { return this->frame_times.GetStats(); };
+    unsigned int GetQueuedEventCount() { return this->queued_event_count; };
+    float GetRemainingFrameTime() { return this->frame_time; };
     unsigned int GetRenderedEntitiesCount() { return this->render_count; };
+    TimingSamples::Stats GetRenderTimeStats() const { return this->render_times.GetStats(); };
+    unsigned long long GetScriptAllocationsPerFrame() { return this->script_frame_allocations; };
+    size_t GetScriptHeapLiveBytes() { return this->script_heap_live; };
+    size_t GetScriptHeapPeakBytes() { return this->script_heap_peak; };
+    unsigned int GetSpriteBatchCount() { return this->sprite_batch_count; };
     unsigned int GetTotalEntitiesCount() { return this->entity_count; };
+    unsigned int GetUpdateCount() { return this->update_count; };
+    TimingSamples::Stats GetUpdateTimeStats() const { return this->update_times.GetStats(); };
     void NewFrame();
-    void RenderedEntity();
+    void QueuedEvent();
+    void RenderedEntity(unsigned int = 1);
+    void RenderFinished();
+    void RenderStarted();
     void Reset();
+    void SampledScriptHeap(size_t, size_t, unsigned long long);
+    void SetFixedStep(bool fixed_step) { this->fixed_step = fixed_step; };
+    void SubmittedSpriteBatch();
+    void TestedCollisionPair();
     void Updated();
+    void UpdatesFinished();
+    void UpdatesStarted();
+    void WriteSummary(std::ostream &);
 
   private:
     const float delta_time{1.0f / CB_DESIRED_UPS};
+    bool fixed_step{false};
 
-    float fps;
-    unsigned int ticks;
-    unsigned int last_ticks;
-    unsigned int frame_time;
+    Uint64 counter_frequency;
+    Uint64 start_counter;
+    Uint64 last_counter;
+    Uint64 phase_counter;
+    float frame_time;
     unsigned int frame_count;
     unsigned int entity_count;
     unsigned int render_count;
     unsigned int update_count;
+    unsigned int collision_pair_count;
+    unsigned int sprite_batch_count;
+    unsigned int queued_event_count;
+    unsigned int executed_event_count;
+    size_t script_heap_live;
+    size_t script_heap_peak;
+    unsigned long long script_allocations;
+    unsigned long long script_frame_allocations;
+    TimingSamples frame_times;
+    TimingSamples update_times;
+    TimingSamples render_times;
+
+    float GetMillisecondsSince(Uint64) const;
 };
 
 class Engine {
@@ -104,6 +188,9 @@ class Engine {
     FontManager fonts;
     CB_Rect display_bounds;
     EngineCounters counters;
+    EntityRegistry entities;
+    JobSystem jobs;
+    TimerWheel timers;
     std::shared_ptr<Viewport> viewport{std::make_shared<Viewport>()};
     InputManager input;
     Scripting::ScriptEngine scripts;
@@ -118,17 +205,21 @@ class Engine {
     int GetMaxTextureWidth() const { return this->max_texture_width; };
     std::shared_ptr<ResourceLoader> GetResourceLoader() const;
     SDL_Renderer * GetRenderer() const { return this->renderer; };
-    void IterateEntities(EntityIterateFunction<Entity>);
-    void IterateActiveColliders(EntityIterateFunction<BoxCollider>);
-    void IterateActiveEntities(EntityIterateFunction<Entity>);
-    void IterateActiveGuiPanels(EntityIterateFunction<Gui::GuiPanel>);
-    void IterateActiveSprites(EntityIterateFunction<Sprite>);
+    template <typename F> void IterateEntities(F);
+    template <typename F> void IterateActiveColliders(F);
+    template <typename F> void IterateActiveEntities(F);
+    template <typename F> void IterateActiveGuiPanels(F);
+    template <typename F> void IterateActiveSprites(F);
+    void QueueDestroy(std::shared_ptr<Entity>);
     int Run();
     void SetConfiguration(std::shared_ptr<EngineConfiguration>);
 
   private:
     SDL_Window * window{nullptr};
     SDL_Renderer * renderer{nullptr};
+    SDL_Surface * headless_surface{nullptr};
+    RenderList render_list;
+    std::vector<std::weak_ptr<Entity>> destroy_queue;
     int max_texture_height{0};
     int max_texture_width{0};
     bool initialized{false};
@@ -138,6 +229,7 @@ class Engine {
     Engine(Engine &&) = delete;
     void operator=(Engine const &) = delete;
     bool ConfigureManagers();
+    bool CreateHeadlessRenderer();
     bool CreateWindowAndRenderer();
     void DestroyMarkedEntities();
     void RenderDebugPane();
@@ -147,15 +239,24 @@ class Engine {
 class Sprite;
 
 typedef std::function<void()> PreUpdateEvent;
-typedef std::function<void()> CollisionEvent;
 
+typedef struct CollisionEvent {
+    entity_id_t entity_id;
+    entity_id_t other_entity_id;
+} CollisionEvent;
+
+/*
+ * Events deferred to a later point in the frame. Each queue is double buffered: executing a queue swaps it with its
+ * (already cleared) spare, so events queued while running land in the next batch and neither buffer gives back its
+ * memory between frames.
+ */
 class EngineEventQueue {
     friend Engine;
 
   public:
     ~EngineEventQueue(){};
     static EngineEventQueue & GetInstance();
-    void QueueCollision(const CollisionEvent);
+    void QueueCollision(const CollisionEvent &);
     void QueuePreUpdate(const PreUpdateEvent);
 
   protected:
@@ -164,12 +265,83 @@ class EngineEventQueue {
 
   private:
     std::vector<CollisionEvent> collision;
+    std::vector<CollisionEvent> collision_executing;
     std::vector<PreUpdateEvent> pre_update;
+    std::vector<PreUpdateEvent> pre_update_executing;
 
     EngineEventQueue(){};
     EngineEventQueue(const EngineEventQueue &) = delete;
     EngineEventQueue(EngineEventQueue &&) = delete;
     void operator=(EngineEventQueue const &) = delete;
 };
+
+/*
+ * Entity iteration. Visitors are called with a reference to each entity (no shared_ptr copies) and return true to
+ * stop iterating. These are templates so the visitor can be inlined into the loops over each entity collection.
+ * Those collections are still vectors of shared_ptr, so every visit follows a pointer, and inactive entities are
+ * skipped with a branch rather than partitioned out.
+ */
+// TODO: contiguous per-type entity storage with active entities kept first. Entities would have to stop being owned
+// through shared_ptr first: the registry, destroy queue and script callbacks track them with weak_ptr, and the script
+// and animation calls take shared_ptr.
+template <typename F> void Engine::IterateEntities(F func) {
+    if (this->scenes.IsCurrentSceneActive()) {
+        if (this->scenes.current_scene->HasTilemap()) {
+            // the tilemap's collision regions are static and started when they're created, so they're skipped
+            if (func(static_cast<Entity &>(*this->scenes.current_scene->GetTilemap()))) {
+                return;
+            }
+        }
+        for (auto & sprite : this->scenes.current_scene->sprites.sprites) {
+            if (func(static_cast<Entity &>(*sprite))) {
+                return;
+            }
+        }
+    }
+    for (auto & panel : this->gui.panels) {
+        if (func(static_cast<Entity &>(*panel))) {
+            return;
+        }
+        for (auto & control : panel->children) {
+            if (func(static_cast<Entity &>(*control))) {
+                return;
+            }
+        }
+    }
+    func(static_cast<Entity &>(*this->viewport));
+}
+
+template <typename F> void Engine::IterateActiveColliders(F func) {
+    // map collision is tested against the tilemap's collision grid, its regions aren't visited here
+    if (this->scenes.IsCurrentSceneActive()) {
+        for (auto & sprite : this->scenes.current_scene->sprites.sprites) {
+            if (sprite->IsActive() && func(static_cast<BoxCollider &>(*sprite))) {
+                return;
+            }
+        }
+    }
+}
+
+template <typename F> void Engine::IterateActiveEntities(F func) {
+    this->IterateEntities([&func](Entity & entity) { return entity.IsActive() && func(entity); });
+}
+
+template <typename F> void Engine::IterateActiveGuiPanels(F func) {
+    for (auto & panel : this->gui.panels) {
+        if (panel->IsActive() && func(*panel)) {
+            return;
+        }
+    }
+}
+
+template <typename F> void Engine::IterateActiveSprites(F func) {
+    if (this->scenes.IsCurrentSceneActive()) {
+        for (auto & sprite : this->scenes.current_scene->sprites.sprites) {
+            if (sprite->IsActive() && func(*sprite)) {
+                return;
+            }
+        }
+    }
+}
 }
 #endif
\ No newline at end of file
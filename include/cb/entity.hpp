@@ -6,6 +6,9 @@
 
 #include <cassert>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "coord.hpp"
 
@@ -22,7 +25,9 @@ extern entity_id_t next_entity_id;
 
 namespace Scripting {
 class Script;
+struct CB_ScriptCallback;
 }
+class SpriteBatch;
 
 class Entity : public std::enable_shared_from_this<Entity> {
     friend class Engine;
@@ -32,14 +37,21 @@ class Entity : public std::enable_shared_from_this<Entity> {
     CB_Rect dim{0, 0, 0, 0};
     std::string tag;
     std::shared_ptr<Scripting::Script> script;
+    // pending script delay/interval callbacks, and whether any are parked until the entity is running again
+    std::vector<std::shared_ptr<Scripting::CB_ScriptCallback>> callbacks;
+    bool callbacks_paused{false};
     float time_scale{1.0f};
     EntityState state{EntityState::New};
 
     virtual EntityType GetEntityType() const = 0;
+    virtual unsigned int GetRenderLayers() const { return 0; };
+    virtual SDL_Texture * GetRenderTexture() const { return nullptr; };
+    virtual unsigned int GetRenderTextureOrdinal() const { return 0; };
     bool HasScript() { return this->script != nullptr; };
     bool IsActive() { return this->state == EntityState::Active && this->destroyed == false; };
-    void MarkDestroy() { this->destroyed = true; };
+    void MarkDestroy();
     void Render(SDL_Renderer *, const CB_ViewClippingInfo &);
+    bool RenderBatched(SpriteBatch &, const CB_ViewClippingInfo &);
     virtual void SetPosition(int x, int y) {
       if (this->IsActive()) {
         this->dim.x = x;
@@ -57,6 +69,7 @@ class Entity : public std::enable_shared_from_this<Entity> {
     bool IsDestroyed() { return this->destroyed; };
     virtual bool OnStart() { return true; };
     virtual void OnRender(SDL_Renderer *, const CB_ViewClippingInfo &) {};
+    virtual bool OnRenderBatched(SpriteBatch &, const CB_ViewClippingInfo &) { return false; };
     virtual void OnDebugRender(SDL_Renderer *, const CB_ViewClippingInfo &) {};
     virtual void OnUpdate(float){};
 
@@ -64,5 +77,42 @@ class Entity : public std::enable_shared_from_this<Entity> {
     bool started{false};
     bool destroyed{false};
 };
+
+/*
+ * Engine-wide lookup of loaded entities by ID and by tag. Entities are registered when they are loaded and
+ * unregistered when they are unloaded; only weak references are held, so the owning collections still control
+ * entity lifetime. Tags are interned on registration and are expected not to change while registered.
+ */
+class EntityRegistry {
+  public:
+    EntityRegistry(){};
+    void Clear();
+    std::shared_ptr<Entity> Find(entity_id_t) const;
+    void FindByTag(const std::string &, std::vector<std::shared_ptr<Entity>> *) const;
+    size_t GetEntityCount() const { return this->entities.size(); };
+    void Register(std::shared_ptr<Entity>);
+    void Unregister(entity_id_t);
+
+  private:
+    typedef unsigned int tag_id_t;
+    struct RegisteredEntity {
+        std::weak_ptr<Entity> entity;
+        tag_id_t tag_id;
+        size_t tag_index;
+    };
+    struct TaggedEntity {
+        entity_id_t entity_id;
+        std::weak_ptr<Entity> entity;
+    };
+
+    std::unordered_map<entity_id_t, RegisteredEntity> entities;
+    std::unordered_map<std::string, tag_id_t> tag_ids;
+    std::vector<std::vector<TaggedEntity>> tagged_entities;
+
+    tag_id_t InternTag(const std::string &);
+
+    EntityRegistry(const EntityRegistry &) = delete;
+    EntityRegistry(EntityRegistry &&) = delete;
+};
 }
 #endif
\ No newline at end of file
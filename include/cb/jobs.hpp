@@ -0,0 +1,113 @@
+#pragma once
+#ifndef CBJOBS_HPP
+#define CBJOBS_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define CB_JOBS_MAX_WORKERS 16
+#define CB_JOBS_ANIMATION_GRAIN 64
+#define CB_JOBS_CULLING_GRAIN 256
+#define CB_JOBS_COLLIDER_GRAIN 256
+#define CB_JOBS_TILEMAP_GRAIN 8
+
+namespace Critterbits {
+typedef std::function<void()> Job;
+
+/*
+ * Counts outstanding jobs. Jobs scheduled against a counter decrement it when they finish, so it can be waited on
+ * (or checked) as a dependency by whatever needs their results.
+ */
+class JobCounter {
+    friend class JobSystem;
+
+  public:
+    JobCounter(){};
+    bool IsDone() const { return this->pending.load(std::memory_order_acquire) == 0; };
+
+  private:
+    std::atomic<int> pending{0};
+
+    JobCounter(const JobCounter &) = delete;
+    JobCounter(JobCounter &&) = delete;
+};
+
+/*
+ * Fixed pool of worker threads. Each thread (including the main thread, which owns queue 0) pushes and pops jobs at
+ * the back of its own queue, and steals from the front of the other queues when it runs dry. With no workers started
+ * every job simply runs inline on the calling thread.
+ */
+class JobSystem {
+  public:
+    JobSystem(){};
+    ~JobSystem();
+    unsigned int GetWorkerCount() const { return static_cast<unsigned int>(this->workers.size()); };
+    bool IsRunning() const { return this->running; };
+    template <typename F> void ParallelFor(size_t, size_t, F);
+    void Schedule(Job, JobCounter *);
+    bool Start(int);
+    void Stop();
+    void Wait(JobCounter &);
+
+  private:
+    struct JobEntry {
+        Job job;
+        JobCounter * counter;
+    };
+    struct JobQueue {
+        std::mutex mutex;
+        std::deque<JobEntry> jobs;
+    };
+
+    std::vector<std::unique_ptr<JobQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<bool> running{false};
+    std::atomic<int> queued_jobs{0};
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem(JobSystem &&) = delete;
+    bool PopJob(unsigned int, JobEntry *);
+    bool RunOneJob();
+    void WorkerMain(unsigned int);
+};
+
+/*
+ * Splits [0, count) into chunks of at least grain items and calls func(begin, end) for each chunk, returning once
+ * all of them have finished. The calling thread works on chunks too rather than just waiting.
+ */
+template <typename F> void JobSystem::ParallelFor(size_t count, size_t grain, F func) {
+    if (grain == 0) {
+        grain = 1;
+    }
+    if (!this->running || count <= grain) {
+        if (count > 0) {
+            func(static_cast<size_t>(0), count);
+        }
+        return;
+    }
+
+    // a few chunks per thread gives stealing something to balance without drowning in tiny jobs
+    size_t max_chunks = (this->workers.size() + 1) * 4;
+    size_t chunk_size = (count + max_chunks - 1) / max_chunks;
+    if (chunk_size < grain) {
+        chunk_size = grain;
+    }
+
+    JobCounter counter;
+    for (size_t begin = chunk_size; begin < count; begin += chunk_size) {
+        size_t end = begin + chunk_size < count ? begin + chunk_size : count;
+        this->Schedule([&func, begin, end]() { func(begin, end); }, &counter);
+    }
+    func(static_cast<size_t>(0), chunk_size);
+    this->Wait(counter);
+}
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#ifndef CBPOOLALLOCATOR_HPP
+#define CBPOOLALLOCATOR_HPP
+
+#include <cstddef>
+#include <vector>
+
+#define CB_POOL_CHUNK_SIZE 65536
+#define CB_POOL_SIZE_CLASS_COUNT 10
+#define CB_POOL_MAX_POOLED_SIZE 512
+
+namespace Critterbits {
+/*
+ * Size-class allocator for heaps that churn through lots of small blocks (i.e. the script runtime). Requests up to
+ * CB_POOL_MAX_POOLED_SIZE are carved out of large chunks and recycled through a free list per size class, anything
+ * bigger goes straight to malloc. Each block carries a small header with its size, so it can be reallocated or freed
+ * without being told how big it is, and live/peak byte counts stay exact.
+ */
+class PoolAllocator {
+  public:
+    struct Stats {
+        size_t live_bytes{0};
+        size_t peak_bytes{0};
+        size_t reserved_bytes{0};
+        size_t limit_bytes{0};
+        unsigned long long allocations{0};
+        unsigned long long failed_allocations{0};
+    };
+
+    PoolAllocator(){};
+    ~PoolAllocator();
+    void * Allocate(size_t);
+    void Free(void *);
+    const Stats & GetStats() const { return this->stats; };
+    void * Reallocate(void *, size_t);
+    void SetLimit(size_t limit_bytes) { this->stats.limit_bytes = limit_bytes; };
+
+  private:
+    struct FreeBlock {
+        FreeBlock * next;
+    };
+
+    Stats stats;
+    FreeBlock * free_lists[CB_POOL_SIZE_CLASS_COUNT]{};
+    std::vector<char *> chunks;
+    char * chunk_next{nullptr};
+    char * chunk_end{nullptr};
+
+    PoolAllocator(const PoolAllocator &) = delete;
+    PoolAllocator(PoolAllocator &&) = delete;
+    char * AllocateBlock(int);
+    static int GetSizeClass(size_t);
+    bool IsOverLimit(size_t) const;
+};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+#ifndef CBPROFILER_HPP
+#define CBPROFILER_HPP
+
+#include <SDL.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_set>
+
+#include "entity.hpp"
+
+#define CB_PROFILER_EVENT_CAPACITY 65536
+#define CB_PROFILER_TRACE_FILE "cbtrace.json"
+#define CB_PROFILE_PHASE_COUNT 9
+
+#define CB_PROFILE_CONCAT_(a, b) a##b
+#define CB_PROFILE_CONCAT(a, b) CB_PROFILE_CONCAT_(a, b)
+#define CB_PROFILE_PHASE(phase) Critterbits::ProfileScope CB_PROFILE_CONCAT(cb_profile_scope_, __LINE__){phase}
+#define CB_PROFILE_SPAN(span, name) \
+    Critterbits::ProfileScope CB_PROFILE_CONCAT(cb_profile_scope_, __LINE__){span, name}
+
+namespace Critterbits {
+enum class ProfilePhase {
+    PollEvents,
+    CheckInputs,
+    UploadTextures,
+    PreUpdate,
+    Update,
+    Collision,
+    Render,
+    Present,
+    DestroyEntities
+};
+enum class ProfileSpan { Entities, Scripts };
+
+/*
+ * Frame profiler. Timed spans are written to a fixed size ring buffer (slots are claimed with an atomic counter, so
+ * any thread may record) that can be exported as Chrome trace_event JSON. Engine phases are also summed per frame
+ * for the debug pane.
+ */
+class Profiler {
+  public:
+    ~Profiler(){};
+    static const char * GetEntityTypeName(EntityType);
+    static Profiler & GetInstance();
+    double GetPhaseTime(ProfilePhase) const;
+    static const char * GetPhaseName(ProfilePhase);
+    const char * InternName(const std::string &);
+    bool IsEnabled() const { return this->enabled; };
+    bool IsSpanEnabled(ProfileSpan span) const {
+        return this->enabled && (span == ProfileSpan::Entities ? this->entity_spans : this->script_spans);
+    };
+    void NewFrame();
+    void Record(const char *, Uint64, Uint64);
+    void RecordPhase(ProfilePhase, Uint64, Uint64);
+    void SetEnabled(bool, bool, bool);
+    bool WriteChromeTrace(const std::string &) const;
+
+  private:
+    struct ProfileEvent {
+        std::atomic<size_t> sequence{0};
+        const char * name{nullptr};
+        Uint64 start{0};
+        Uint64 end{0};
+        unsigned int thread_id{0};
+    };
+
+    bool enabled{false};
+    bool entity_spans{false};
+    bool script_spans{false};
+    Uint64 frequency{1};
+    Uint64 start_counter{0};
+    Uint64 phase_counts[CB_PROFILE_PHASE_COUNT]{};
+    Uint64 last_phase_counts[CB_PROFILE_PHASE_COUNT]{};
+    std::unique_ptr<ProfileEvent[]> events;
+    std::atomic<size_t> next_event{0};
+    std::unordered_set<std::string> names;
+
+    Profiler();
+    Profiler(const Profiler &) = delete;
+    Profiler(Profiler &&) = delete;
+    void operator=(Profiler const &) = delete;
+};
+
+/*
+ * Times the enclosing scope. Does nothing (beyond one flag check) when the profiler, or the requested span
+ * category, is turned off.
+ */
+class ProfileScope {
+  public:
+    ProfileScope(ProfilePhase phase) {
+        if (Profiler::GetInstance().IsEnabled()) {
+            this->phase = static_cast<int>(phase);
+            this->start = SDL_GetPerformanceCounter();
+        }
+    };
+    ProfileScope(ProfileSpan span, const char * name) {
+        if (Profiler::GetInstance().IsSpanEnabled(span)) {
+            this->name = name;
+            this->start = SDL_GetPerformanceCounter();
+        }
+    };
+    ProfileScope(ProfileSpan span, const std::string & name) {
+        Profiler & profiler = Profiler::GetInstance();
+        if (profiler.IsSpanEnabled(span)) {
+            this->name = profiler.InternName(name);
+            this->start = SDL_GetPerformanceCounter();
+        }
+    };
+    ~ProfileScope() {
+        if (this->phase >= 0) {
+            Profiler::GetInstance().RecordPhase(static_cast<ProfilePhase>(this->phase), this->start,
+                                                SDL_GetPerformanceCounter());
+        } else if (this->name != nullptr) {
+            Profiler::GetInstance().Record(this->name, this->start, SDL_GetPerformanceCounter());
+        }
+    };
+
+  private:
+    int phase{-1};
+    const char * name{nullptr};
+    Uint64 start{0};
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope(ProfileScope &&) = delete;
+};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+#ifndef CBRENDER_HPP
+#define CBRENDER_HPP
+
+#include <SDL.h>
+
+#include <memory>
+#include <vector>
+
+#include "color.hpp"
+#include "coord.hpp"
+#include "entity.hpp"
+
+#define CB_WORLD_LAYER_COUNT 3
+
+// SDL_RenderGeometry is only available from SDL 2.0.18 onwards; older versions draw each quad immediately
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#define CB_SPRITE_BATCHING
+#endif
+
+namespace Critterbits {
+class Scene;
+class Sprite;
+class Viewport;
+
+/*
+ * Accumulates textured quads and submits them with one SDL_RenderGeometry call per run of the same texture. Tint,
+ * opacity and flips are baked into the vertices so the shared texture's color/alpha mod is never touched.
+ */
+class SpriteBatch {
+  public:
+    SpriteBatch(){};
+    void Draw(SDL_Renderer *, SDL_Texture *, const CB_Rect &, const CB_Rect &, const CB_Color &, bool = false,
+              bool = false);
+    void Flush(SDL_Renderer *);
+
+  private:
+    SDL_Texture * texture{nullptr};
+#ifdef CB_SPRITE_BATCHING
+    float texture_w{1.0f};
+    float texture_h{1.0f};
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+#endif
+
+    SpriteBatch(const SpriteBatch &) = delete;
+    SpriteBatch(SpriteBatch &&) = delete;
+};
+
+/*
+ * Per-frame list of world entities to draw. Built once per frame by culling against the viewport, bucketed by
+ * z-index and grouped by texture within each bucket, then replayed in order.
+ */
+class RenderList {
+  public:
+    RenderList(){};
+    void Build(Scene *, Viewport &, bool);
+    void Clear();
+    size_t GetItemCount() const;
+    void Render(SDL_Renderer *) const;
+
+  private:
+    struct RenderItem {
+        Entity * entity;
+        unsigned int texture_ordinal;
+        CB_ViewClippingInfo clip;
+    };
+
+    struct CullChunk {
+        std::vector<RenderItem> layers[CB_WORLD_LAYER_COUNT];
+        unsigned int active_count;
+        unsigned int visible_count;
+    };
+
+    std::vector<RenderItem> layers[CB_WORLD_LAYER_COUNT];
+    std::vector<CullChunk> cull_chunks;
+    mutable SpriteBatch batch;
+
+    RenderList(const RenderList &) = delete;
+    RenderList(RenderList &&) = delete;
+    void AddEntity(Entity &, Viewport &);
+    void AddSpritesParallel(const std::vector<std::shared_ptr<Sprite>> &, Viewport &);
+    static bool CollectEntity(Entity &, const Viewport &, std::vector<RenderItem> *);
+};
+}
+#endif
\ No newline at end of file
@@ -7,10 +7,12 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 
 #include <SDL.h>
 
 #include "assetpack.hpp"
+#include "jobs.hpp"
 
 #ifdef _WIN32
 const char PATH_SEP = '\\';
@@ -22,6 +24,7 @@ const char PATH_SEP = '/';
 
 #define CB_FONT_MIN_SIZE 6
 #define CB_FONT_MAX_SIZE 72
+#define CB_TEXTURE_UPLOAD_BUDGET_MS 2.0f
 
 // forward declaration from SDL_ttf.h
 typedef struct _TTF_Font TTF_Font;
@@ -56,6 +59,7 @@ class ResourceLoader {
     virtual std::shared_ptr<TTF_FontWrapper> GetFontResource(const std::string &, int) const = 0;
     virtual std::shared_ptr<SDL_Texture> GetImageResource(const std::string &) const = 0;
     virtual std::shared_ptr<SDL_Surface> GetImageResourceAsSurface(const std::string &) const = 0;
+    virtual bool GetScriptBytecode(const std::string &, unsigned long, std::string **) const = 0;
     virtual bool GetTextResourceContents(const std::string &, std::string **) const = 0;
     virtual std::shared_ptr<std::istream> OpenTextResource(const std::string &) const = 0;
     virtual bool ResourceExists(const std::string &) const = 0;
@@ -73,6 +77,7 @@ class AssetPackResourceLoader : public ResourceLoader {
     std::shared_ptr<TTF_FontWrapper> GetFontResource(const std::string &, int) const;
     std::shared_ptr<SDL_Texture> GetImageResource(const std::string &) const;
     std::shared_ptr<SDL_Surface> GetImageResourceAsSurface(const std::string &) const;
+    bool GetScriptBytecode(const std::string &, unsigned long, std::string **) const;
     bool GetTextResourceContents(const std::string &, std::string **) const;
     std::shared_ptr<std::istream> OpenTextResource(const std::string &) const;
     bool ResourceExists(const std::string &) const;
@@ -81,7 +86,11 @@ class AssetPackResourceLoader : public ResourceLoader {
     AssetPack::CB_AssetPackHeader header;
     std::map<std::string, AssetPack::CB_AssetDictEntry> dict;
     std::unique_ptr<std::ifstream> pack;
+    // images are decoded on worker threads, so reads from the shared stream have to take turns
+    mutable std::mutex pack_mutex;
     bool compressed{false};
+
+    char * ReadAsset(const AssetPack::CB_AssetDictEntry &) const;
 };
 
 class FileResourceLoader : public ResourceLoader {
@@ -91,6 +100,7 @@ class FileResourceLoader : public ResourceLoader {
     std::shared_ptr<TTF_FontWrapper> GetFontResource(const std::string &, int) const;
     std::shared_ptr<SDL_Texture> GetImageResource(const std::string &) const;
     std::shared_ptr<SDL_Surface> GetImageResourceAsSurface(const std::string &) const;
+    bool GetScriptBytecode(const std::string &, unsigned long, std::string **) const;
     bool GetTextResourceContents(const std::string &, std::string **) const;
     std::shared_ptr<std::istream> OpenTextResource(const std::string &) const;
     bool ResourceExists(const std::string &) const;
@@ -98,6 +108,28 @@ class FileResourceLoader : public ResourceLoader {
 
 typedef std::function<void(SDL_Renderer *, SDL_Texture *)> TextureCreateFunction;
 
+/*
+ * Handle for a texture that is loading in the background. The image is read and decoded to a surface on a worker
+ * thread; the upload to the renderer happens on the main thread in TextureManager::UploadPendingTextures.
+ */
+class PendingTexture {
+    friend class TextureManager;
+
+  public:
+    PendingTexture(){};
+    std::shared_ptr<SDL_Texture> GetTexture() const { return this->texture; };
+    bool IsResolved() const { return this->resolved; };
+
+  private:
+    JobCounter decoding;
+    std::shared_ptr<SDL_Surface> surface;
+    std::shared_ptr<SDL_Texture> texture;
+    bool resolved{false};
+
+    PendingTexture(const PendingTexture &) = delete;
+    PendingTexture(PendingTexture &&) = delete;
+};
+
 class TextureManager {
   public:
     TextureManager();
@@ -106,16 +138,25 @@ class TextureManager {
     void CleanUp();
     std::shared_ptr<SDL_Texture> CreateTargetTexture(int, int, float, TextureCreateFunction);
     std::shared_ptr<SDL_Texture> GetTexture(const std::string &, const std::string & = "");
+    std::shared_ptr<PendingTexture> GetTextureAsync(const std::string &, const std::string & = "");
+    size_t GetPendingTextureCount() const { return this->pending_textures.size(); };
+    unsigned int GetTextureOrdinal(const std::string &, const std::string & = "");
     bool IsInitialized() const { return this->initialized; };
     void SetResourceLoader(std::shared_ptr<ResourceLoader>);
+    void UploadPendingTextures(float = CB_TEXTURE_UPLOAD_BUDGET_MS);
 
   private:
     bool initialized{false};
     std::map<std::string, std::shared_ptr<SDL_Texture>> textures;
+    std::map<std::string, std::shared_ptr<PendingTexture>> pending_textures;
+    // handed out in the order textures are first asked for, so it doesn't depend on load timing or heap addresses
+    std::map<std::string, unsigned int> texture_ordinals;
     std::shared_ptr<ResourceLoader> loader;
 
     TextureManager(const TextureManager &) = delete;
     TextureManager(TextureManager &&) = delete;
+    std::string GetFinalPath(const std::string &, const std::string &) const;
+    void ResolvePendingTexture(const std::string &, PendingTexture &);
 };
 
 typedef struct CB_NamedFont {
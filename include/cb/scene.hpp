@@ -25,11 +25,12 @@ class Scene {
     float map_scale{1.0f};
     std::string script_path;
     SceneState state{SceneState::New};
-    SpriteManager sprites;
+    ColliderGrid colliders;
+    SpriteManager sprites{&colliders};
 
     Scene(){};
     ~Scene();
-    std::shared_ptr<Tilemap> GetTilemap() { return this->tilemap; };
+    const std::shared_ptr<Tilemap> & GetTilemap() const { return this->tilemap; };
     bool HasTilemap() { return this->tilemap != nullptr; };
     void NotifyLoaded();
     void NotifyUnloaded(bool);
@@ -4,29 +4,46 @@
 
 #include <cassert>
 #include <memory>
+#include <ostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <SDL.h>
 #include <duktape/duktape.h>
 
 #include <cb/entity.hpp>
+#include <cb/memory/poolallocator.hpp>
 #include <cb/sprite.hpp>
 
 #define CB_SCRIPT_GLOBAL_ONCOLLISION "oncollision"
+#define CB_SCRIPT_GLOBAL_ONCOLLISION_ALL "oncollision_all"
 #define CB_SCRIPT_GLOBAL_START "start"
 #define CB_SCRIPT_GLOBAL_UPDATE "update"
+#define CB_SCRIPT_GLOBAL_UPDATE_ALL "update_all"
+#define CB_SCRIPT_ENTRY_POINT_COUNT 6
+#define CB_SCRIPT_PROFILER_FOLDED_FILE "cbscripts.folded"
+#define CB_SCRIPT_PROFILER_MAX_DEPTH 32
+#define CB_SCRIPT_PROFILER_PANE_ENTRIES 4
+// safe point for the script profiler's sampling mode, put in native functions that scripts call often
+#define CB_SCRIPT_SAMPLE_POINT(ctx) Engine::GetInstance().scripts.GetProfiler().SamplePoint(ctx)
 
 namespace Critterbits {
 namespace Scripting {
 
 extern entity_id_t next_callback_id;
 
+enum class ScriptEntryPoint { Start, Update, UpdateAll, OnCollision, OnCollisionAll, Callback };
+
 typedef struct CB_ScriptCallback {
   const entity_id_t callback_id{next_callback_id++};
   std::weak_ptr<Entity> owner;
   int delay{0};
-  int accrued{0};
   bool once{true};
+  // entity time left as of the wheel time the callback was armed at, and the owner's time scale then (0 if parked)
+  float remaining{0.f};
+  float scale{0.f};
+  unsigned long long armed_at{0};
 } CB_ScriptCallback;
 
 class Script {
@@ -36,34 +53,140 @@ class Script {
     std::string script_path;
     std::string script_name;
 
+    void CallBatchedCollisions();
+    void CallBatchedUpdates();
+    void CancelCallback(Entity &, entity_id_t);
     void CallOnCollision(std::shared_ptr<Entity>, std::shared_ptr<Entity>);
     void CallStart(std::shared_ptr<Entity>);
     void CallUpdate(std::shared_ptr<Entity>, float);
+    void FireCallback(std::shared_ptr<Entity>, std::shared_ptr<CB_ScriptCallback>);
+    bool HasBatchedCollision() const { return this->global_oncollision_all; };
+    bool HasBatchedUpdate() const { return this->global_update_all; };
+    bool HasCollisionHandler() const { return this->global_oncollision || this->global_oncollision_all; };
     void QueueCallback(std::unique_ptr<CB_ScriptCallback>);
+    void QueueCollision(std::shared_ptr<Entity>, std::shared_ptr<Entity>);
+    void QueueUpdate(std::shared_ptr<Entity>, float);
+    void RescheduleCallbacks(Entity &);
 
   private:
+    struct BatchedUpdate {
+        float delta_time;
+        std::vector<std::shared_ptr<Entity>> entities;
+    };
+    typedef std::pair<std::shared_ptr<Entity>, std::shared_ptr<Entity>> BatchedCollision;
+
     duk_context * context{nullptr};
     bool global_oncollision{false};
+    bool global_oncollision_all{false};
     bool global_start{false};
     bool global_update{false};
-    std::vector<std::unique_ptr<CB_ScriptCallback>> callbacks;
+    bool global_update_all{false};
+    std::vector<BatchedCollision> batched_collisions;
+    std::vector<BatchedUpdate> batched_updates;
 
     bool CallCallback(std::shared_ptr<Entity>, const CB_ScriptCallback &);
+    void CallOnCollisionAll();
+    void CallUpdateAll(const std::vector<std::shared_ptr<Entity>> &, float);
     void DiscoverGlobals();
-    void PostCallRetrieveAllEntities();
+    void PostCallApplyEntityChanges();
+};
+
+/*
+ * Times calls into scripts per script and entry point. In sampling mode duktape's interrupt counter flags a sample
+ * every so many bytecode instructions. The duktape API can't be used from the interrupt itself, so the JS call stack
+ * is read at the next sample point (a native function called from script) and counted as a folded stack.
+ */
+class ScriptProfiler {
+  public:
+    ScriptProfiler(){};
+    Uint64 BeginCall(const std::string &, ScriptEntryPoint);
+    void EndCall(Uint64);
+    static const char * GetEntryPointName(ScriptEntryPoint);
+    void Interrupt() {
+        if (this->sampling && !this->call_stack.empty()) {
+            this->pending_samples++;
+        }
+    };
+    bool IsEnabled() const { return this->enabled; };
+    bool IsSampling() const { return this->sampling; };
+    void NewFrame();
+    void SamplePoint(duk_context * context) {
+        if (this->pending_samples > 0) {
+            this->CaptureSample(context);
+        }
+    };
+    void SetEnabled(bool, bool);
+    void WriteFrameSummary(std::ostream &, size_t) const;
+    bool WriteFoldedStacks(const std::string &) const;
+
+  private:
+    struct EntryStats {
+        unsigned long calls{0};
+        Uint64 total{0};
+        unsigned long frame_calls{0};
+        Uint64 frame_total{0};
+        unsigned long last_frame_calls{0};
+        Uint64 last_frame_total{0};
+    };
+    struct ScriptStats {
+        EntryStats entry_points[CB_SCRIPT_ENTRY_POINT_COUNT];
+    };
+    struct ActiveCall {
+        const std::string * script_name;
+        ScriptEntryPoint entry_point;
+        EntryStats * stats;
+    };
+
+    bool enabled{false};
+    bool sampling{false};
+    Uint64 frequency{1};
+    unsigned long pending_samples{0};
+    std::vector<ActiveCall> call_stack;
+    std::unordered_map<std::string, ScriptStats> scripts;
+    std::unordered_map<std::string, unsigned long> samples;
+
+    ScriptProfiler(const ScriptProfiler &) = delete;
+    ScriptProfiler(ScriptProfiler &&) = delete;
+    void CaptureSample(duk_context *);
+    std::string GetCallStackKey() const;
+};
+
+/*
+ * Times the enclosing call into a script with the engine's script profiler, if it is turned on.
+ */
+class ScriptProfileScope {
+  public:
+    ScriptProfileScope(const Script &, ScriptEntryPoint);
+    ~ScriptProfileScope();
+
+  private:
+    bool active{false};
+    Uint64 start{0};
+
+    ScriptProfileScope(const ScriptProfileScope &) = delete;
+    ScriptProfileScope(ScriptProfileScope &&) = delete;
 };
 
 class ScriptEngine {
   public:
     ScriptEngine();
     ~ScriptEngine();
+    void CallBatchedCollisions();
+    void CallBatchedUpdates();
+    const PoolAllocator::Stats & GetHeapStats() const { return this->allocator.GetStats(); };
+    ScriptProfiler & GetProfiler() { return this->profiler; };
     std::shared_ptr<Script> GetScriptHandle(const std::string &) const;
     std::shared_ptr<Script> LoadScript(const std::string &);
+    void ReleaseEntity(entity_id_t);
+    void SetHeapLimit(size_t limit_bytes) { this->allocator.SetLimit(limit_bytes); };
     void StartEngine();
 
   private:
+    // declared ahead of the context so it outlives the heap
+    PoolAllocator allocator;
     duk_context * context{nullptr};
     std::vector<std::shared_ptr<Script>> loaded_scripts;
+    ScriptProfiler profiler;
 
     void AddCommonScriptingFunctions(duk_context *) const;
 
@@ -11,14 +11,23 @@
 #include <cb/entity.hpp>
 #include <duktape/duktape.h>
 
-#define CB_SCRIPT_ENTITY_STASH_ARRAY "entities"
+#define CB_SCRIPT_ENTITY_STASH "entities"
 #define CB_SCRIPT_CALLBACK_STASH "callbacks"
-#define CB_SCRIPT_HIDDEN_DESTROYED                                                                                     \
+#define CB_SCRIPT_HIDDEN_DIM                                                                                           \
     "\xff"                                                                                                             \
-    "destroyed"
+    "dim"
 #define CB_SCRIPT_HIDDEN_ENTITYID                                                                                      \
     "\xff"                                                                                                             \
     "entity_id"
+#define CB_SCRIPT_HIDDEN_FRAME                                                                                         \
+    "\xff"                                                                                                             \
+    "frame"
+#define CB_SCRIPT_HIDDEN_POS                                                                                           \
+    "\xff"                                                                                                             \
+    "pos"
+#define CB_SCRIPT_HIDDEN_TINT                                                                                          \
+    "\xff"                                                                                                             \
+    "tint"
 
 // It's easy to leave stuff lying around on the duktape stack unintentionally. Use these as function guards.
 #ifdef NDEBUG
@@ -128,6 +137,22 @@ inline std::string GetPropertyString(duk_context * context, const char * propert
     return std::string(value);
 }
 
+inline void PushPropertyAccessor(duk_context * context, const char * property_name, duk_c_function getter,
+                                 duk_c_function setter, int magic) {
+    // getter and setter share the magic value, so one native pair can serve several properties
+    duk_idx_t obj_index = duk_normalize_index(context, -1);
+    duk_uint_t flags = DUK_DEFPROP_HAVE_GETTER | DUK_DEFPROP_SET_ENUMERABLE;
+    duk_push_string(context, property_name);
+    duk_push_c_function(context, getter, 0);
+    duk_set_magic(context, -1, magic);
+    if (setter != nullptr) {
+        duk_push_c_function(context, setter, 1);
+        duk_set_magic(context, -1, magic);
+        flags |= DUK_DEFPROP_HAVE_SETTER;
+    }
+    duk_def_prop(context, obj_index, flags);
+}
+
 inline void PushPropertyBool(duk_context * context, const char * property_name, bool value) {
     duk_push_boolean(context, value ? 1 : 0);
     // -2 skips over scalar just pushed and assumes target object is right behind it
@@ -184,13 +209,11 @@ inline void PushPropertyString(duk_context * context, const char * property_name
     duk_put_prop_string(context, -2, property_name);
 }
 
-void ClearEntitiesInContext(duk_context *);
+void ApplyPendingEntityChanges();
 
 void CreateEntityInContext(duk_context *, std::shared_ptr<Entity>);
 
-void RetrieveEntityFromContext(duk_context *, std::shared_ptr<Entity>);
-
-void RetrieveEntityFromContextAt(duk_context *, std::shared_ptr<Entity>, int = -1);
+void ReleaseEntityInContext(duk_context *, entity_id_t);
 }
 }
 #endif
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <SDL.h>
@@ -12,6 +13,7 @@
 #include "entity.hpp"
 #include "boxcollider.hpp"
 #include "anim.hpp"
+#include "resource.hpp"
 #include "toml.hpp"
 
 #define CB_SPRITE_PATH "sprites"
@@ -24,7 +26,35 @@ typedef struct QueuedSprite {
   CB_Point at;
 } QueuedSprite;
 
+/*
+ * A sprite's TOML definition, parsed once and then shared read-only by every sprite spawned from it.
+ */
+typedef struct SpritePrefab {
+    typedef struct AnimationDef {
+        std::string name;
+        bool loop{false};
+        bool auto_play{false};
+        std::shared_ptr<const Animation::KeyFrameList> key_frames;
+    } AnimationDef;
+
+    std::string sprite_path;
+    std::string sprite_sheet_path;
+    std::string script_path;
+    std::string tag;
+    float sprite_scale{1.0f};
+    int tile_height{0};
+    int tile_width{0};
+    int tile_offset_x{0};
+    int tile_offset_y{0};
+    CB_Color tint_and_opacity{255, 255, 255, 255};
+    CollisionType collision{CollisionType::None};
+    CB_Rect collision_box;
+    std::vector<AnimationDef> animations;
+} SpritePrefab;
+
 class Sprite : public BoxCollider {
+    friend class SpriteManager;
+
   public:
     std::string sprite_name;
     std::string sprite_path;
@@ -42,9 +72,13 @@ class Sprite : public BoxCollider {
 
     Sprite();
     ~Sprite();
+    void AnimateConcurrently(float);
     EntityType GetEntityType() const { return EntityType::Sprite; };
     inline int GetFrame() const { return this->current_frame; };
     inline int GetFrameCount() const { return this->sprite_sheet_rows * this->sprite_sheet_cols; }
+    unsigned int GetRenderLayers() const;
+    SDL_Texture * GetRenderTexture() const { return this->sprite_sheet.get(); };
+    unsigned int GetRenderTextureOrdinal() const { return this->sprite_sheet_ordinal; };
     void NotifyLoaded();
     void NotifyUnloaded();
     void SetFrame(int);
@@ -53,6 +87,7 @@ class Sprite : public BoxCollider {
   protected:
     bool OnStart();
     void OnRender(SDL_Renderer *, const CB_ViewClippingInfo &);
+    bool OnRenderBatched(SpriteBatch &, const CB_ViewClippingInfo &);
     void OnDebugRender(SDL_Renderer *, const CB_ViewClippingInfo &);
     void OnUpdate(float);
 
@@ -61,30 +96,41 @@ class Sprite : public BoxCollider {
     int sprite_sheet_rows{0};
     int sprite_sheet_cols{0};
     std::shared_ptr<SDL_Texture> sprite_sheet;
+    std::shared_ptr<PendingTexture> pending_sprite_sheet;
+    unsigned int sprite_sheet_ordinal{0};
     bool sprite_sheet_loaded{false};
     bool script_loaded{false};
+    size_t sprite_index{0};
 
     CB_Rect GetFrameRect() const;
+    CB_Rect GetRenderDestRect(const CB_ViewClippingInfo &) const;
 };
 
 class SpriteManager {
   public:
     std::vector<std::shared_ptr<Sprite>> sprites;
 
-    SpriteManager(){};
+    SpriteManager(ColliderGrid * colliders) : colliders(colliders){};
+    void AddSprite(std::shared_ptr<Sprite>);
     bool LoadQueuedSprites();
     void QueueSprite(const QueuedSprite &);
-    void UnloadSprite(std::shared_ptr<Sprite>);
+    void RemoveUnloadedSprites();
+    bool UnloadSprite(std::shared_ptr<Sprite>);
 
   private:
+    ColliderGrid * colliders;
     std::vector<QueuedSprite> queued_sprites;
+    std::unordered_map<std::string, std::shared_ptr<const SpritePrefab>> prefabs;
     bool new_sprites{false};
+    bool unloaded_sprites{false};
 
     SpriteManager(const SpriteManager &) = delete;
     SpriteManager(SpriteManager &&) = delete;
+    std::shared_ptr<const SpritePrefab> GetPrefab(const std::string &);
     std::string GetSpritePath(const std::string &) const;
     std::string GetSpriteSheetPath(const std::string &) const;
-    void ParseSprite(const Toml::TomlParser &, std::shared_ptr<Sprite>) const;
+    std::shared_ptr<Sprite> InstantiatePrefab(const SpritePrefab &, const QueuedSprite &) const;
+    std::shared_ptr<SpritePrefab> ParsePrefab(const Toml::TomlParser &, const std::string &) const;
 };
 }
 #endif
\ No newline at end of file
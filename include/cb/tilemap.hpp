@@ -3,11 +3,13 @@
 #define CBTILEMAP_HPP
 
 #include <SDL.h>
+#include <TmxImage.h>
 #include <TmxMap.h>
 #include <TmxMapTile.h>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "2d.hpp"
 #include "coord.hpp"
@@ -16,6 +18,12 @@
 
 #define CB_TILEMAP_COLLIDE "collide"
 #define CB_TILEMAP_FOREGROUND "foreground"
+// baked map chunks are about this many (scaled) pixels square, rounded down to whole tiles
+#define CB_TILEMAP_CHUNK_SIZE 512
+// how many baked chunks to keep before evicting the least recently drawn ones
+#define CB_TILEMAP_CHUNK_CACHE_SIZE 32
+// how many chunks just outside the view may be baked ahead of time each frame
+#define CB_TILEMAP_CHUNK_PREFETCH 2
 
 #define CB_TILEMAP_TMX_PROP_BOOL_TRUE "true"
 
@@ -25,6 +33,7 @@ class TilemapRegion : public BoxCollider {
     TilemapRegion();
 
     EntityType GetEntityType() const { return EntityType::TilemapRegion; };
+    unsigned int GetRenderLayers() const { return this->debug ? ZIndexMask(ZIndex::Foreground) : 0; };
     void SetPosition(int, int){}; // map regions are static
 
   protected:
@@ -32,22 +41,51 @@ class TilemapRegion : public BoxCollider {
     void OnDebugRender(SDL_Renderer *, const CB_ViewClippingInfo &);
 };
 
+/*
+ * Tiled map. Layers are baked into fixed size chunk textures (one for the background, one for the foreground) as
+ * they come into view, rather than into one texture for the whole map. Chunks with nothing on them are never
+ * created, and the least recently drawn chunks are released once there are more than CB_TILEMAP_CHUNK_CACHE_SIZE.
+ * Collide layers are merged into collision regions and bucketed into a grid over the map's tiles, which is what
+ * colliders test against; TilemapRegion entities are only created for the debug overlay and collision events.
+ */
 class Tilemap : public Entity {
   public:
     int tile_width;
     int tile_height;
-    std::vector<std::shared_ptr<TilemapRegion>> regions;
     SDL_Color bg_color{0, 0, 0, 0};
 
     Tilemap(const std::string &);
     ~Tilemap();
-    bool CreateTextures(float scale);
+    size_t GetBakedChunkCount() const { return this->baked_chunks.size(); };
+    const CB_Rect & GetCollisionRegion(size_t region_index) const { return this->collision_regions[region_index]; };
     EntityType GetEntityType() const { return EntityType::Tilemap; };
-  
+    TilemapRegion * GetRegion(size_t);
+    size_t GetRegionEntityCount() const { return this->region_entity_count; };
+    const std::vector<std::shared_ptr<TilemapRegion>> & GetRegions() const { return this->regions; };
+    unsigned int GetRenderLayers() const { return this->render_layers; };
+    bool HasRegion(size_t region_index) const { return this->regions[region_index] != nullptr; };
+    bool LoadMap(float scale);
+    void QueryCollisionRegions(const CB_Rect &, std::vector<size_t> *) const;
+    void ReleaseChunks();
+
   protected:
     void OnRender(SDL_Renderer *, const CB_ViewClippingInfo &);
 
   private:
+    struct MapChunk {
+        CB_Rect area;
+        CB_Rect dim;
+        SDL_Texture * bg_texture{nullptr};
+        SDL_Texture * fg_texture{nullptr};
+        bool has_bg{false};
+        bool has_fg{false};
+        bool baked{false};
+        unsigned long last_used{0};
+    };
+    struct TileSource {
+        int tileset_index{-1};
+        CB_Rect srcrect;
+    };
     struct MapTileInfo {
         int row;
         int col;
@@ -55,20 +93,59 @@ class Tilemap : public Entity {
         int offsety;
         int alpha_mod;
     };
+    struct MapTileDraw {
+        int tileset_index;
+        CB_Rect srcrect;
+        CB_Rect dstrect;
+        bool flip_x;
+        bool flip_y;
+        double rotate;
+    };
     std::string tmx_path;
     std::unique_ptr<Tmx::Map> map{nullptr};
-    SDL_Texture * bg_map_texture{nullptr};
-    SDL_Texture * fg_map_texture{nullptr};
     bool draw_debug{false};
     float render_scale{1.0f};
+    unsigned int render_layers{0};
+    std::vector<MapChunk> chunks;
+    std::vector<size_t> baked_chunks;
+    int chunk_cols{0};
+    int chunk_rows{0};
+    CB_Point chunk_map_size;
+    CB_Point min_tileset_tile;
+    CB_Point max_tileset_tile;
+    unsigned long render_stamp{0};
+    std::vector<TileSource> tile_sources;
+    std::vector<std::shared_ptr<SDL_Texture>> tileset_textures;
+    bool tiles_overlap{false};
+    std::vector<std::vector<MapTileDraw>> tile_draw_groups;
+    std::vector<CB_Rect> collision_regions;
+    // one slot per collision region, only filled in once that region is needed as an entity (see GetRegion). Regions
+    // are static, so they're kept here rather than with the scene's entities and only the collision code and the
+    // debug overlay ever look at them.
+    std::vector<std::shared_ptr<TilemapRegion>> regions;
+    std::vector<unsigned int> collision_cells;
+    std::vector<size_t> collision_cell_regions;
+    float collision_cell_w{1.0f};
+    float collision_cell_h{1.0f};
+    size_t region_entity_count{0};
 
-    bool RenderMap(SDL_Renderer *, float);
-    void CreateCollisionRegion(const CB_Rect &);
-    void DrawImageLayer(SDL_Renderer *, const Tmx::ImageLayer *);
-    void DrawMapLayer(SDL_Renderer *, const Tmx::TileLayer *, RectRegionCombiner *);
-    void DrawObjectLayer(SDL_Renderer *, const Tmx::ObjectGroup *);
-    inline void DrawTileOnMap(SDL_Renderer *, const Tmx::MapTile &, const MapTileInfo &,
-                              RectRegionCombiner * = nullptr);
+    bool BakeChunk(SDL_Renderer *, size_t);
+    void BuildCollisionGrid();
+    void BuildTileSources();
+    void CreateRegions();
+    void DrawImageLayer(SDL_Renderer *, const Tmx::ImageLayer *, const CB_Point &);
+    void DrawMapLayer(SDL_Renderer *, const Tmx::TileLayer *, const CB_Rect &);
+    void DrawObjectLayer(SDL_Renderer *, const Tmx::ObjectGroup *, const CB_Point &);
+    inline void DrawTileOnMap(SDL_Renderer *, const Tmx::MapTile &, const MapTileInfo &, const CB_Point &);
+    void DrawTiles(SDL_Renderer *, const std::vector<MapTileDraw> &, int, const CB_Point &);
+    void EvictChunks(size_t);
+    CB_Rect GetCollisionCellRange(const CB_Rect &) const;
+    bool GetTileDraw(const Tmx::MapTile &, const MapTileInfo &, MapTileDraw *) const;
+    void IndexImageLayer(const Tmx::ImageLayer *, bool);
+    void IndexMap();
+    void IndexMapLayer(const Tmx::TileLayer *, bool, RectRegionCombiner *);
+    void IndexObjectLayer(const Tmx::ObjectGroup *, bool);
+    void MarkChunks(const CB_Rect &, bool);
 };
 
 class TilesetImageManager {
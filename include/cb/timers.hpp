@@ -0,0 +1,58 @@
+#pragma once
+#ifndef CBTIMERS_HPP
+#define CBTIMERS_HPP
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// each level of the wheel has 2^bits slots; four levels of 64 one-millisecond slots cover about 4.6 hours, longer
+// timers wait in the last level and cascade again until they are in range
+#define CB_TIMER_WHEEL_BITS 6
+#define CB_TIMER_WHEEL_LEVELS 4
+
+namespace Critterbits {
+typedef unsigned long timer_id_t;
+typedef std::function<void()> TimerFunction;
+
+/*
+ * Hierarchical timer wheel with millisecond ticks. Scheduling and cancelling are O(1), and each tick only looks at
+ * the one slot that is due (plus, every 64 ticks, the slot one level up cascading down), so firing cost doesn't
+ * depend on how many timers are pending.
+ */
+class TimerWheel {
+  public:
+    TimerWheel();
+    void Advance(float);
+    bool Cancel(timer_id_t);
+    size_t GetPendingCount() const { return this->timers.size(); };
+    unsigned long long GetTime() const { return this->now; };
+    void Schedule(timer_id_t, unsigned int, TimerFunction);
+
+  private:
+    typedef unsigned long long tick_t;
+    struct TimerEntry {
+        timer_id_t timer_id;
+        tick_t expires;
+        // matches the timer's record, so entries left behind by a cancel or reschedule are skipped
+        unsigned long generation;
+    };
+    struct Timer {
+        TimerFunction func;
+        unsigned long generation;
+    };
+
+    tick_t now{0};
+    float partial_ms{0.f};
+    unsigned long next_generation{0};
+    std::vector<std::vector<TimerEntry>> slots;
+    std::unordered_map<timer_id_t, Timer> timers;
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel(TimerWheel &&) = delete;
+    int Cascade(int);
+    void Insert(const TimerEntry &);
+    void Tick();
+};
+}
+#endif
\ No newline at end of file
@@ -2,20 +2,15 @@
 
 namespace Critterbits {
 namespace Animation {
-void KeyFrameAnimation::AddKeyFrame(const KeyFrame & key_frame) {
-    this->key_frames.push_back(key_frame);
-    this->key_frame_count++;
-}
-
 void KeyFrameAnimation::Animate(std::shared_ptr<Entity> entity, float delta_time) {
     if (this->IsPlaying()) {
         this->key_frame_delta += delta_time;
         if (this->key_frame_delta >= this->next_key_frame_at) {
-            if (static_cast<size_t>(this->next_key_frame) < this->key_frames.size()) {
-                const KeyFrame & key_frame = this->key_frames.at(this->next_key_frame);
+            if (static_cast<size_t>(this->next_key_frame) < this->key_frames->size()) {
+                const KeyFrame & key_frame = this->key_frames->at(this->next_key_frame);
                 this->AnimateKeyFrame(entity, key_frame);
                 this->key_frame_delta = 0.f;
-                if (++this->next_key_frame == this->key_frame_count) {
+                if (static_cast<size_t>(++this->next_key_frame) == this->key_frames->size()) {
                     this->next_key_frame = 0;
                     if (!this->loop) {
                         this->Stop();
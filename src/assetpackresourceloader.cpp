@@ -27,6 +27,9 @@ void read_dict_entry(std::ifstream & ifs, AssetPack::CB_AssetDictEntry * entry)
     entry->index = ntohl(entry->index);
     entry->pos = ntohl(entry->pos);
     entry->length = ntohl(entry->length);
+    entry->format = ntohl(entry->format);
+    entry->format_version = ntohl(entry->format_version);
+    entry->checksum = ntohl(entry->checksum);
 }
 }
 
@@ -35,6 +38,12 @@ AssetPackResourceLoader::AssetPackResourceLoader(const BaseResourcePath & res_pa
     this->pack = std::unique_ptr<std::ifstream>{new std::ifstream{res_path.base_path, std::ifstream::binary}};
     if (this->pack->good()) {
         read_header(*this->pack, &this->header);
+        if (this->header._version[0] != CB_ASSETPACK_VER_MAJ) {
+            LOG_ERR("AssetPackResourceLoader asset pack " + res_path.base_path + " has version " +
+                    std::to_string(this->header._version[0]) + "." + std::to_string(this->header._version[1]) +
+                    ", expected " + std::to_string(CB_ASSETPACK_VER_MAJ) + ".x (rebuild it with assetpacker)");
+            return;
+        }
         this->compressed = TestBitMask<unsigned int>(this->header.flags, CB_ASSETPACK_FLAGS_COMPRESSED);
         this->pack->seekg(this->header.table_pos);
 
@@ -55,10 +64,7 @@ std::shared_ptr<TTF_FontWrapper> AssetPackResourceLoader::GetFontResource(const
         LOG_INFO("AssetPackResourceLoader::GetFontResource loading asset " + asset_path + " at position " +
                  std::to_string(it->second.pos) + " with length " + std::to_string(it->second.length));
         std::shared_ptr<TTF_FontWrapper> wrapper = std::make_shared<TTF_FontWrapper>();
-        wrapper->buffer = new char[it->second.length];
-        this->pack->clear();
-        this->pack->seekg(it->second.pos);
-        this->pack->read(wrapper->buffer, it->second.length);
+        wrapper->buffer = this->ReadAsset(it->second);
         SDL_RWops * rwops = SDL_RWFromMem(wrapper->buffer, it->second.length);
         wrapper->font = TTF_OpenFontRW(rwops, 1, pt_size);
         if (wrapper->font == nullptr) {
@@ -77,10 +83,7 @@ std::shared_ptr<SDL_Texture> AssetPackResourceLoader::GetImageResource(const std
     if (it != this->dict.end()) {
         LOG_INFO("AssetPackResourceLoader::GetImageResource loading asset " + asset_path + " at position " +
                  std::to_string(it->second.pos) + " with length " + std::to_string(it->second.length));
-        char * buffer = new char[it->second.length];
-        this->pack->clear();
-        this->pack->seekg(it->second.pos);
-        this->pack->read(buffer, it->second.length);
+        char * buffer = this->ReadAsset(it->second);
         SDL_RWops * rwops = SDL_RWFromMem(buffer, it->second.length);
         SDL_Texture * texture = IMG_LoadTextureTyped_RW(Engine::GetInstance().GetRenderer(), rwops, 1, "PNG");
         delete[] buffer;
@@ -102,10 +105,7 @@ std::shared_ptr<SDL_Surface> AssetPackResourceLoader::GetImageResourceAsSurface(
     if (it != this->dict.end()) {
         LOG_INFO("AssetPackResourceLoader::GetImageResource loading asset " + asset_path + " at position " +
                  std::to_string(it->second.pos) + " with length " + std::to_string(it->second.length));
-        char * buffer = new char[it->second.length];
-        this->pack->clear();
-        this->pack->seekg(it->second.pos);
-        this->pack->read(buffer, it->second.length);
+        char * buffer = this->ReadAsset(it->second);
         SDL_RWops * rwops = SDL_RWFromMem(buffer, it->second.length);
         SDL_Surface * surface = IMG_LoadTyped_RW(rwops, 1, "PNG");
         delete[] buffer;
@@ -122,6 +122,35 @@ std::shared_ptr<SDL_Surface> AssetPackResourceLoader::GetImageResourceAsSurface(
     return nullptr;
 }
 
+bool AssetPackResourceLoader::GetScriptBytecode(const std::string & asset_path, unsigned long version,
+                                                std::string ** bytecode) const {
+    auto it = this->dict.find(asset_path + CB_ASSETPACK_BYTECODE_SUFFIX);
+    if (it == this->dict.end()) {
+        return false;
+    }
+    const AssetPack::CB_AssetDictEntry & entry = it->second;
+    if (entry.format != CB_ASSETPACK_FORMAT_SCRIPT_BYTECODE || entry.length < 1) {
+        LOG_ERR("AssetPackResourceLoader::GetScriptBytecode asset is not script bytecode " + asset_path);
+        return false;
+    }
+    if (entry.format_version != version) {
+        LOG_INFO("AssetPackResourceLoader::GetScriptBytecode bytecode for " + asset_path + " was built for version " +
+                 std::to_string(entry.format_version) + ", expected " + std::to_string(version));
+        return false;
+    }
+
+    // duktape doesn't validate bytecode, so a damaged entry must never reach duk_load_function
+    char * buffer = this->ReadAsset(entry);
+    if (AssetPack::Checksum(buffer, entry.length) != entry.checksum) {
+        LOG_ERR("AssetPackResourceLoader::GetScriptBytecode checksum mismatch for " + asset_path);
+        delete[] buffer;
+        return false;
+    }
+    *bytecode = new std::string(buffer, entry.length);
+    delete[] buffer;
+    return true;
+}
+
 bool AssetPackResourceLoader::GetTextResourceContents(const std::string & asset_path,
                                                       std::string ** text_content) const {
     auto it = this->dict.find(asset_path);
@@ -131,8 +160,6 @@ bool AssetPackResourceLoader::GetTextResourceContents(const std::string & asset_
     const AssetPack::CB_AssetDictEntry & entry = it->second;
     LOG_INFO("AssetPackResourceLoader::GetTextResourceContents loading asset " + asset_path + " at pack position " +
              std::to_string(entry.pos) + " with length " + std::to_string(entry.length));
-    this->pack->clear();
-    this->pack->seekg(entry.pos);
 
     if (entry.length < 1) {
         *text_content = new std::string{};
@@ -140,7 +167,10 @@ bool AssetPackResourceLoader::GetTextResourceContents(const std::string & asset_
     } else if (this->compressed) {
         // TODO
     } else {
+        std::lock_guard<std::mutex> lock{this->pack_mutex};
         char * buffer = new char[entry.length];
+        this->pack->clear();
+        this->pack->seekg(entry.pos);
         this->pack->read(buffer, entry.length);
         *text_content = new std::string(buffer, this->pack->gcount());
         delete[] buffer;
@@ -158,6 +188,15 @@ std::shared_ptr<std::istream> AssetPackResourceLoader::OpenTextResource(const st
     return nullptr;
 }
 
+char * AssetPackResourceLoader::ReadAsset(const AssetPack::CB_AssetDictEntry & entry) const {
+    std::lock_guard<std::mutex> lock{this->pack_mutex};
+    char * buffer = new char[entry.length];
+    this->pack->clear();
+    this->pack->seekg(entry.pos);
+    this->pack->read(buffer, entry.length);
+    return buffer;
+}
+
 bool AssetPackResourceLoader::ResourceExists(const std::string & asset_path) const {
     return this->dict.find(asset_path) != this->dict.end();
 }
@@ -1,6 +1,41 @@
+#include <algorithm>
+
 #include <cb/critterbits.hpp>
 
 namespace Critterbits {
+namespace {
+inline bool IsCollider(EntityType entity_type) {
+    return entity_type == EntityType::Sprite || entity_type == EntityType::TilemapRegion;
+}
+
+bool ResolveOverlap(const CB_Rect & coll_box, CollisionType collision, int old_x, int old_y, CB_Rect * new_dim) {
+    if (!AabbCollision(*new_dim, coll_box)) {
+        return false;
+    }
+
+    // if full collision, adjust new x/y so they're not inside the collided sprite
+    if (collision == CollisionType::Collide) {
+        if (new_dim->x > old_x) {
+            new_dim->x = std::max(old_x, coll_box.x - new_dim->w);
+        } else if (new_dim->x < old_x) {
+            new_dim->x = std::min(old_x, coll_box.right());
+        }
+        if (new_dim->y > old_y) {
+            new_dim->y = std::max(old_y, coll_box.y - new_dim->h);
+        } else if (new_dim->y < old_y) {
+            new_dim->y = std::min(old_y, coll_box.bottom());
+        }
+    }
+    return true;
+}
+}
+
+BoxCollider::~BoxCollider() {
+    if (this->collider_grid != nullptr) {
+        this->collider_grid->Remove(this);
+    }
+}
+
 bool BoxCollider::IsCollidingWith(entity_id_t entity_id) {
     for (auto & eid : this->is_colliding_with) {
         if (eid == entity_id) {
@@ -21,71 +56,74 @@ CB_Point BoxCollider::GetValidPosition(int old_x, int old_y, int new_x, int new_
         new_dim.x = new_x;
         new_dim.y = new_y;
 
+        // colliders we're touching at the final position (used to expire collision de-dupe records)
+        std::vector<entity_id_t> touching;
+        std::vector<BoxCollider *> candidates;
+
+        // static map collision is looked up on the current tilemap's collision grid rather than the collider grid
+        SceneManager & scenes = Engine::GetInstance().scenes;
+        Tilemap * tilemap = nullptr;
+        if (scenes.IsCurrentSceneActive() && scenes.current_scene->HasTilemap()) {
+            tilemap = scenes.current_scene->GetTilemap().get();
+        }
+        std::vector<size_t> map_regions;
+        entity_id_t region_id;
+
         do {
             // these get reset on each loop to check if we got moved by collision
             new_x = new_dim.x;
             new_y = new_dim.y;
+            touching.clear();
+
+            // static map regions first, then other colliders
+            if (tilemap != nullptr) {
+                map_regions.clear();
+                tilemap->QueryCollisionRegions(new_dim, &map_regions);
+                for (size_t region_index : map_regions) {
+                    if (this->TestMapCollision(*tilemap, region_index, old_x, old_y, &new_dim, &region_id) &&
+                        region_id != CB_ENTITY_ID_INVALID) {
+                        touching.push_back(region_id);
+                    }
+                }
+            }
 
-            Engine::GetInstance().IterateActiveColliders([&](std::shared_ptr<BoxCollider> collider) {
-                if (collider->entity_id != this->entity_id) {
-                    if (collider->collision == CollisionType::Collide || collider->collision == CollisionType::Trigger) {
-                        // check for collision
-                        CB_Rect coll_box{collider->GetCollisionRect()};
-                        if (AabbCollision(new_dim, coll_box)) {
-                            // if full collision, adjust new x/y so they're not inside the collided sprite
-                            if (collider->collision == CollisionType::Collide) {
-                                if (new_dim.x > old_x) {
-                                    new_dim.x = std::max(old_x, coll_box.x - new_dim.w);
-                                } else if (new_dim.x < old_x) {
-                                    new_dim.x = std::min(old_x, coll_box.right());
-                                }
-                                if (new_dim.y > old_y) {
-                                    new_dim.y = std::max(old_y, coll_box.y - new_dim.h);
-                                } else if (new_dim.y < old_y) {
-                                    new_dim.y = std::min(old_y, coll_box.bottom());
-                                }
-                            }
-
-                            // notify both sprites that a collision occurred
-                            this->NotifyCollision(collider);
-                            collider->NotifyCollision(std::dynamic_pointer_cast<BoxCollider>(this->shared_from_this()));
-                        } else {
-                            this->RemoveCollisionWith(collider->entity_id);
-                        }
+            if (this->collider_grid != nullptr) {
+                // broadphase: only test colliders that share a grid cell with the new position
+                candidates.clear();
+                this->collider_grid->Query(new_dim, &candidates);
+                for (auto collider : candidates) {
+                    if (collider->IsActive() && this->TestCollision(collider, old_x, old_y, &new_dim)) {
+                        touching.push_back(collider->entity_id);
                     }
                 }
-                return false;
-            });
+            } else {
+                Engine::GetInstance().IterateActiveColliders([&](BoxCollider & collider) {
+                    if (this->TestCollision(&collider, old_x, old_y, &new_dim)) {
+                        touching.push_back(collider.entity_id);
+                    }
+                    return false;
+                });
+            }
         } while (new_dim.x != new_x || new_dim.y != new_y);
+
+        for (auto it = this->is_colliding_with.begin(); it != this->is_colliding_with.end();) {
+            if (std::find(touching.begin(), touching.end(), *it) == touching.end()) {
+                it = this->is_colliding_with.erase(it);
+            } else {
+                it++;
+            }
+        }
     }
     return CB_Point{new_x, new_y};
 }
 
-void BoxCollider::NotifyCollision(std::weak_ptr<BoxCollider> other) {
-    if (auto oth = other.lock()) {
-        if (oth->IsActive() && !this->IsCollidingWith(oth->entity_id)) {
-            // record the collision (this is used for de-dupe)
-            this->is_colliding_with.push_back(oth->entity_id);
-
-            // queue up an event for the collision
-            std::weak_ptr<BoxCollider> current = std::dynamic_pointer_cast<BoxCollider>(this->shared_from_this());
-            EngineEventQueue::GetInstance().QueueCollision([other, current]() {
-                if (auto cent = current.lock()) {
-                    if (auto oent = other.lock()) {
-                        // call oncollision script if it exists
-                        if (cent->HasScript()) {
-                            cent->script->CallOnCollision(cent, oent);
-                        }
-
-                        // full colliders reset after every hit, triggers will collide only once until the colliding
-                        // object leaves the trigger area
-                        if (cent->collision == CollisionType::Collide && oent->collision != CollisionType::Trigger) {
-                            cent->RemoveCollisionWith(oent->entity_id);
-                        }
-                    }
-                }
-            });
-        }
+void BoxCollider::NotifyCollision(BoxCollider * other) {
+    if (other->IsActive() && !this->IsCollidingWith(other->entity_id)) {
+        // record the collision (this is used for de-dupe)
+        this->is_colliding_with.push_back(other->entity_id);
+
+        // queue up an event for the collision
+        EngineEventQueue::GetInstance().QueueCollision(CollisionEvent{this->entity_id, other->entity_id});
     }
 }
 
@@ -97,4 +135,71 @@ void BoxCollider::RemoveCollisionWith(entity_id_t entity_id) {
         }
     }
 }
+
+void BoxCollider::ResolveCollision(const std::shared_ptr<Entity> & entity,
+                                   const std::shared_ptr<Entity> & other_entity) {
+    if (!IsCollider(entity->GetEntityType()) || !IsCollider(other_entity->GetEntityType())) {
+        return;
+    }
+    BoxCollider * current = static_cast<BoxCollider *>(entity.get());
+    BoxCollider * other = static_cast<BoxCollider *>(other_entity.get());
+
+    // call oncollision script if it exists
+    if (current->HasScript()) {
+        if (current->script->HasBatchedCollision()) {
+            current->script->QueueCollision(entity, other_entity);
+        } else {
+            current->script->CallOnCollision(entity, other_entity);
+        }
+    }
+
+    // full colliders reset after every hit, triggers will collide only once until the colliding object leaves the
+    // trigger area
+    if (current->collision == CollisionType::Collide && other->collision != CollisionType::Trigger) {
+        current->RemoveCollisionWith(other->entity_id);
+    }
+}
+
+bool BoxCollider::TestCollision(BoxCollider * collider, int old_x, int old_y, CB_Rect * new_dim) {
+    if (collider->entity_id == this->entity_id ||
+        (collider->collision != CollisionType::Collide && collider->collision != CollisionType::Trigger)) {
+        return false;
+    }
+
+    // check for collision
+    Engine::GetInstance().counters.TestedCollisionPair();
+    if (!ResolveOverlap(collider->GetCollisionRect(), collider->collision, old_x, old_y, new_dim)) {
+        return false;
+    }
+
+    // notify both sprites that a collision occurred
+    this->NotifyCollision(collider);
+    collider->NotifyCollision(this);
+    return true;
+}
+
+bool BoxCollider::TestMapCollision(Tilemap & tilemap, size_t region_index, int old_x, int old_y, CB_Rect * new_dim,
+                                   entity_id_t * region_id) {
+    Engine::GetInstance().counters.TestedCollisionPair();
+    if (!ResolveOverlap(tilemap.GetCollisionRegion(region_index), CollisionType::Collide, old_x, old_y, new_dim)) {
+        return false;
+    }
+
+    // the region only has to be an entity if something will see the collision event
+    if (tilemap.HasRegion(region_index) || (this->HasScript() && this->script->HasCollisionHandler())) {
+        TilemapRegion * region = tilemap.GetRegion(region_index);
+        this->NotifyCollision(region);
+        region->NotifyCollision(this);
+        *region_id = region->entity_id;
+    } else {
+        *region_id = CB_ENTITY_ID_INVALID;
+    }
+    return true;
+}
+
+void BoxCollider::UpdateGridPosition() {
+    if (this->collider_grid != nullptr) {
+        this->collider_grid->Move(this);
+    }
+}
 }
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include <algorithm>
+
+#include <cb/critterbits.hpp>
+
+namespace Critterbits {
+namespace {
+inline int floor_div(int value, int divisor) {
+    int quotient = value / divisor;
+    if ((value % divisor != 0) && ((value < 0) != (divisor < 0))) {
+        quotient--;
+    }
+    return quotient;
+}
+}
+
+ColliderGrid::~ColliderGrid() { this->Clear(); }
+
+void ColliderGrid::AddToCells(BoxCollider * collider, const CB_Rect & cell_range) {
+    for (int y = cell_range.y; y < cell_range.bottom(); y++) {
+        for (int x = cell_range.x; x < cell_range.right(); x++) {
+            this->cells[GetCellKey(x, y)].push_back(collider);
+        }
+    }
+}
+
+void ColliderGrid::Clear() {
+    for (auto & cell : this->cells) {
+        for (auto collider : cell.second) {
+            collider->collider_grid = nullptr;
+        }
+    }
+    this->cells.clear();
+    this->collider_count = 0;
+}
+
+CB_Rect ColliderGrid::GetCellRange(const CB_Rect & rect) const {
+    // CB_Rect::intersects() counts touching edges, so the right/bottom edge is inclusive here too
+    int x1 = floor_div(rect.x, this->cell_size);
+    int y1 = floor_div(rect.y, this->cell_size);
+    int x2 = floor_div(rect.right(), this->cell_size);
+    int y2 = floor_div(rect.bottom(), this->cell_size);
+    return CB_Rect{x1, y1, std::max(x2 - x1, 0) + 1, std::max(y2 - y1, 0) + 1};
+}
+
+void ColliderGrid::Insert(BoxCollider * collider) {
+    if (collider->collider_grid == this) {
+        this->Move(collider);
+        return;
+    } else if (collider->collider_grid != nullptr) {
+        collider->collider_grid->Remove(collider);
+    }
+    collider->collider_grid = this;
+    collider->collider_grid_cells = this->GetCellRange(collider->GetCollisionRect());
+    this->AddToCells(collider, collider->collider_grid_cells);
+    this->collider_count++;
+}
+
+void ColliderGrid::InsertAll(const std::vector<BoxCollider *> & colliders, bool parallel) {
+    // cell ranges don't depend on each other, so they can be worked out on the job system; bucketing into the
+    // shared map stays on this thread
+    std::vector<CB_Rect> cell_ranges(colliders.size());
+    auto get_cell_ranges = [this, &colliders, &cell_ranges](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            cell_ranges[i] = this->GetCellRange(colliders[i]->GetCollisionRect());
+        }
+    };
+    if (parallel) {
+        Engine::GetInstance().jobs.ParallelFor(colliders.size(), CB_JOBS_COLLIDER_GRAIN, get_cell_ranges);
+    } else {
+        get_cell_ranges(0, colliders.size());
+    }
+
+    this->cells.reserve(this->cells.size() + colliders.size());
+    for (size_t i = 0; i < colliders.size(); i++) {
+        BoxCollider * collider = colliders[i];
+        if (collider->collider_grid != nullptr) {
+            this->Insert(collider);
+            continue;
+        }
+        collider->collider_grid = this;
+        collider->collider_grid_cells = cell_ranges[i];
+        this->AddToCells(collider, collider->collider_grid_cells);
+        this->collider_count++;
+    }
+}
+
+void ColliderGrid::Move(BoxCollider * collider) {
+    if (collider->collider_grid != this) {
+        return;
+    }
+    CB_Rect new_cells = this->GetCellRange(collider->GetCollisionRect());
+    if (new_cells != collider->collider_grid_cells) {
+        this->RemoveFromCells(collider, collider->collider_grid_cells);
+        this->AddToCells(collider, new_cells);
+        collider->collider_grid_cells = new_cells;
+    }
+}
+
+void ColliderGrid::Query(const CB_Rect & rect, std::vector<BoxCollider *> * colliders) const {
+    CB_Rect cell_range = this->GetCellRange(rect);
+    size_t first = colliders->size();
+    for (int y = cell_range.y; y < cell_range.bottom(); y++) {
+        for (int x = cell_range.x; x < cell_range.right(); x++) {
+            auto cell = this->cells.find(GetCellKey(x, y));
+            if (cell != this->cells.end()) {
+                colliders->insert(colliders->end(), cell->second.begin(), cell->second.end());
+            }
+        }
+    }
+
+    // colliders spanning several cells show up more than once; order by entity ID so results are stable
+    std::sort(colliders->begin() + first, colliders->end(),
+              [](const BoxCollider * lhs, const BoxCollider * rhs) { return lhs->entity_id < rhs->entity_id; });
+    colliders->erase(std::unique(colliders->begin() + first, colliders->end()), colliders->end());
+}
+
+void ColliderGrid::Remove(BoxCollider * collider) {
+    if (collider->collider_grid != this) {
+        return;
+    }
+    this->RemoveFromCells(collider, collider->collider_grid_cells);
+    collider->collider_grid = nullptr;
+    this->collider_count--;
+}
+
+void ColliderGrid::RemoveFromCells(BoxCollider * collider, const CB_Rect & cell_range) {
+    for (int y = cell_range.y; y < cell_range.bottom(); y++) {
+        for (int x = cell_range.x; x < cell_range.right(); x++) {
+            auto cell = this->cells.find(GetCellKey(x, y));
+            if (cell == this->cells.end()) {
+                continue;
+            }
+            std::vector<BoxCollider *> & members = cell->second;
+            auto it = std::find(members.begin(), members.end(), collider);
+            // empty cells are kept around so sprites moving back and forth don't thrash the allocator
+            if (it != members.end()) {
+                *it = members.back();
+                members.pop_back();
+            }
+        }
+    }
+}
+}
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <climits>
 #include <iomanip>
 #include <iostream>
 #include <list>
@@ -16,10 +18,13 @@ Engine::Engine() {
     } else {
         this->initialized = true;
     }
+
+    // the viewport lives as long as the engine does
+    this->entities.Register(this->viewport);
 }
 
 Engine::~Engine() {
-    SDLx::SDL_CleanUp(this->renderer, this->window);
+    SDLx::SDL_CleanUp(this->renderer, this->window, this->headless_surface);
     SDL_Quit();
 }
 
@@ -38,12 +43,50 @@ bool Engine::ConfigureManagers() {
     this->input.SetKeyboardActive(this->config->input.keyboard);
     this->input.SetMouseActive(this->config->input.mouse);
 
+    // start worker threads
+    this->jobs.Start(this->config->threading.workers);
+
     // start scripting engine
+    this->scripts.SetHeapLimit(static_cast<size_t>(std::max(this->config->scripting.heap_limit_kb, 0)) * 1024);
     this->scripts.StartEngine();
 
     return false;
 }
 
+bool Engine::CreateHeadlessRenderer() {
+    LOG_INFO("Engine::CreateHeadlessRenderer running headless at " + std::to_string(this->config->window.width) + "x" +
+             std::to_string(this->config->window.height));
+
+    // configure viewport
+    int viewport_w = static_cast<int>(static_cast<float>(this->config->window.width) / this->config->rendering.scale);
+    int viewport_h = static_cast<int>(static_cast<float>(this->config->window.height) / this->config->rendering.scale);
+    this->viewport->dim = {0, 0, viewport_w, viewport_h};
+
+    // no window, render into an offscreen surface instead
+    this->headless_surface =
+        SDL_CreateRGBSurface(0, this->config->window.width, this->config->window.height, 32, 0, 0, 0, 0);
+    if (this->headless_surface == nullptr) {
+        LOG_SDL_ERR("Engine::CreateHeadlessRenderer SDL_CreateRGBSurface");
+        return true;
+    }
+    this->renderer = SDL_CreateSoftwareRenderer(this->headless_surface);
+    if (this->renderer == nullptr) {
+        LOG_SDL_ERR("Engine::CreateHeadlessRenderer SDL_CreateSoftwareRenderer");
+        return true;
+    }
+
+    // the software renderer reports 0 when it has no texture size limit
+    SDL_RendererInfo r_info;
+    if (SDL_GetRendererInfo(this->renderer, &r_info) != 0) {
+        LOG_SDL_ERR("Engine::CreateHeadlessRenderer SDL_GetRendererInfo");
+        return true;
+    }
+    this->max_texture_height = r_info.max_texture_height > 0 ? r_info.max_texture_height : INT_MAX;
+    this->max_texture_width = r_info.max_texture_width > 0 ? r_info.max_texture_width : INT_MAX;
+
+    return false;
+}
+
 bool Engine::CreateWindowAndRenderer() {
     // discover display bounds
     SDL_Rect disp_bounds;
@@ -106,20 +149,25 @@ bool Engine::CreateWindowAndRenderer() {
 }
 
 void Engine::DestroyMarkedEntities() {
-    // copy all the entities to a vector first, as destruction will alter underlying collections
-    std::vector<std::shared_ptr<Entity>> destroyed_entities;
-    this->IterateEntities([&destroyed_entities](std::shared_ptr<Entity> entity) {
-        if (entity->destroyed) {
-            destroyed_entities.push_back(entity);
-        }
-        return false;
-    });
+    if (this->destroy_queue.empty()) {
+        return;
+    }
+
+    // swap the queue out first, as destruction may mark further entities
+    std::vector<std::weak_ptr<Entity>> destroyed_entities;
+    destroyed_entities.swap(this->destroy_queue);
 
-    for (auto & entity : destroyed_entities) {
+    for (auto & weak_entity : destroyed_entities) {
+        std::shared_ptr<Entity> entity = weak_entity.lock();
+        if (entity == nullptr || !entity->destroyed) {
+            continue;
+        }
         switch (entity->GetEntityType()) {
             case EntityType::Sprite:
-                if (this->scenes.IsCurrentSceneActive()) {
-                    this->scenes.current_scene->sprites.UnloadSprite(std::dynamic_pointer_cast<Sprite>(entity));
+                // sprites belonging to an inactive scene are kept queued until that scene is current again
+                if (!this->scenes.IsCurrentSceneActive() ||
+                    !this->scenes.current_scene->sprites.UnloadSprite(std::dynamic_pointer_cast<Sprite>(entity))) {
+                    this->destroy_queue.push_back(weak_entity);
                 }
                 break;
             case EntityType::GuiPanel:
@@ -138,29 +186,28 @@ void Engine::DestroyMarkedEntities() {
                 break;
         }
     }
+
+    // unloaded sprites leave empty slots behind, close them up in one pass
+    if (this->scenes.IsCurrentSceneActive()) {
+        this->scenes.current_scene->sprites.RemoveUnloadedSprites();
+    }
 }
 
 std::shared_ptr<Entity> Engine::FindEntityById(entity_id_t entity_id) {
-    std::shared_ptr<Entity> ret{nullptr};
-    this->IterateActiveEntities([&](std::shared_ptr<Entity> entity) {
-        if (entity->entity_id == entity_id) {
-            ret = entity;
-            return true;
-        }
-        return false;
-    });
-    return ret;
+    std::shared_ptr<Entity> entity = this->entities.Find(entity_id);
+    if (entity != nullptr && entity->IsActive()) {
+        return entity;
+    }
+    return nullptr;
 }
 
 std::vector<std::shared_ptr<Entity>> Engine::FindEntitiesByTag(const std::string & tag) {
     std::vector<std::shared_ptr<Entity>> entities;
     if (!tag.empty()) {
-        this->IterateActiveEntities([&](std::shared_ptr<Entity> entity) {
-            if (entity->tag == tag) {
-                entities.push_back(entity);
-            }
-            return false;
-        });
+        this->entities.FindByTag(tag, &entities);
+        entities.erase(std::remove_if(entities.begin(), entities.end(),
+                                      [](const std::shared_ptr<Entity> & entity) { return !entity->IsActive(); }),
+                       entities.end());
     }
     return entities;
 }
@@ -178,103 +225,7 @@ std::shared_ptr<ResourceLoader> Engine::GetResourceLoader() const {
     return this->config->loader;
 }
 
-void Engine::IterateEntities(EntityIterateFunction<Entity> func) {
-    if (this->scenes.IsCurrentSceneActive()) {
-        if (this->scenes.current_scene->HasTilemap()) {
-            if (func(this->scenes.current_scene->GetTilemap())) {
-                return;
-            }
-            for (auto & region : this->scenes.current_scene->GetTilemap()->regions) {
-                if (func(region)) {
-                    return;
-                }
-            }
-        }
-        for (auto & sprite : this->scenes.current_scene->sprites.sprites) {
-            if (func(sprite)) {
-                return;
-            }
-        }
-    }
-    for (auto & panel : this->gui.panels) {
-        if (func(panel)) {
-            return;
-        }
-        for (auto & control : panel->children) {
-            if (func(control)) {
-                return;
-            }
-        }
-    }
-    if (func(this->viewport)) {
-        return;
-    }
-}
-
-void Engine::IterateActiveColliders(EntityIterateFunction<BoxCollider> func) {
-    EntityIterateFunction<BoxCollider> wrapper = [&func](std::shared_ptr<BoxCollider> collider) {
-        if (collider->IsActive()) {
-            return func(collider);
-        }
-        return false;
-    };
-
-    if (this->scenes.IsCurrentSceneActive()) {
-        if (this->scenes.current_scene->HasTilemap()) {
-            for (auto & region : this->scenes.current_scene->GetTilemap()->regions) {
-                if (wrapper(region)) {
-                    return;
-                }
-            }
-        }
-        for (auto & sprite : this->scenes.current_scene->sprites.sprites) {
-            if (wrapper(sprite)) {
-                return;
-            }
-        }
-    }
-}
-
-void Engine::IterateActiveEntities(EntityIterateFunction<Entity> func) {
-    EntityIterateFunction<Entity> wrapper = [&func](std::shared_ptr<Entity> entity) {
-        if (entity->IsActive()) {
-            return func(entity);
-        }
-        return false;
-    };
-    this->IterateEntities(wrapper);
-}
-
-void Engine::IterateActiveGuiPanels(EntityIterateFunction<Gui::GuiPanel> func) {
-    EntityIterateFunction<Gui::GuiPanel> wrapper = [&func](std::shared_ptr<Gui::GuiPanel> panel) {
-        if (panel->IsActive()) {
-            return func(panel);
-        }
-        return false;
-    };
-    for (auto & panel : this->gui.panels) {
-        if (func(panel)) {
-            return;
-        }
-    }
-}
-
-void Engine::IterateActiveSprites(EntityIterateFunction<Sprite> func) {
-    EntityIterateFunction<Sprite> wrapper = [&func](std::shared_ptr<Sprite> sprite) {
-        if (sprite->IsActive()) {
-            return func(sprite);
-        }
-        return false;
-    };
-
-    if (this->scenes.IsCurrentSceneActive()) {
-        for (auto & sprite : this->scenes.current_scene->sprites.sprites) {
-            if (wrapper(sprite)) {
-                return;
-            }
-        }
-    }
-}
+void Engine::QueueDestroy(std::shared_ptr<Entity> entity) { this->destroy_queue.push_back(entity); }
 
 int Engine::Run() {
     LOG_INFO("Entering Engine::Run()");
@@ -291,7 +242,12 @@ int Engine::Run() {
     }
 
     // create SDL window and renderer
-    if (this->CreateWindowAndRenderer()) {
+    if (this->config->headless.enabled) {
+        if (this->CreateHeadlessRenderer()) {
+            LOG_ERR("Engine::Run unable to create headless renderer");
+            return 1;
+        }
+    } else if (this->CreateWindowAndRenderer()) {
         LOG_ERR("Engine::Run unable to create SDL window/renderer");
         return 1;
     }
@@ -306,103 +262,183 @@ int Engine::Run() {
     this->SetWindowIcon();
 
     // load first scene
-    if (!this->scenes.LoadScene(CB_FIRST_SCENE)) {
-        LOG_ERR("Engine::Run cannot load startup scene");
+    if (!this->scenes.LoadScene(this->config->first_scene)) {
+        LOG_ERR("Engine::Run cannot load first scene " + this->config->first_scene);
         return 1;
     }
 
+    // headless runs simulate one fixed update per frame as fast as possible, unless asked to keep real time
+    this->counters.SetFixedStep(this->config->headless.enabled && !this->config->headless.realtime);
+    bool render = !this->config->headless.enabled || this->config->headless.render;
+
+    Profiler & profiler = Profiler::GetInstance();
+    profiler.SetEnabled(this->config->debug.profile, this->config->debug.profile_entities,
+                        this->config->debug.profile_scripts);
+    Scripting::ScriptProfiler & script_profiler = this->scripts.GetProfiler();
+    script_profiler.SetEnabled(this->config->debug.profile && this->config->debug.profile_scripts,
+                               this->config->debug.profile_script_sampling);
+
     // start main loop
     SDL_Event e;
     bool quit = false;
     while (!quit) {
         // timing update
         this->counters.NewFrame();
+        profiler.NewFrame();
+        script_profiler.NewFrame();
 
         // check for waiting SDL events
-        while (SDL_PollEvent(&e)) {
-            // If user closes the window
-            if (e.type == SDL_QUIT) {
-                quit = true;
-            }
+        {
+            CB_PROFILE_PHASE(ProfilePhase::PollEvents);
+            while (SDL_PollEvent(&e)) {
+                // If user closes the window
+                if (e.type == SDL_QUIT) {
+                    quit = true;
+                }
 
-            // InputManager will process the event if it's input-related
-            this->input.AddSdlEvent(e);
+                // dump profiler trace on demand
+                if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F10 && profiler.IsEnabled()) {
+                    profiler.WriteChromeTrace(CB_PROFILER_TRACE_FILE);
+                    if (script_profiler.IsEnabled()) {
+                        script_profiler.WriteFoldedStacks(CB_SCRIPT_PROFILER_FOLDED_FILE);
+                    }
+                }
+
+                // InputManager will process the event if it's input-related
+                this->input.AddSdlEvent(e);
+            }
         }
 
         // check input state (non-event)
-        this->input.CheckInputs();
+        {
+            CB_PROFILE_PHASE(ProfilePhase::CheckInputs);
+            this->input.CheckInputs();
+        }
+
+        // upload any textures that finished decoding in the background
+        {
+            CB_PROFILE_PHASE(ProfilePhase::UploadTextures);
+            this->textures.UploadPendingTextures();
+        }
 
         // begin simulation loop
+        this->counters.UpdatesStarted();
         while (this->counters.GetRemainingFrameTime() > 0) {
             float dt = this->counters.GetDeltaFromRemainingFrameTime();
 
             // Execute pre-update events
-            EngineEventQueue::GetInstance().ExecutePreUpdate();
+            {
+                CB_PROFILE_PHASE(ProfilePhase::PreUpdate);
+                EngineEventQueue::GetInstance().ExecutePreUpdate();
+            }
 
             // Update cycle
-            this->IterateEntities([dt](std::shared_ptr<Entity> entity) {
-                // start entity if it hasn't already
-                entity->Start();
-
-                // call frame update methods
-                entity->Update(dt);
-
-                return false;
-            });
+            {
+                CB_PROFILE_PHASE(ProfilePhase::Update);
+                this->IterateEntities([dt](Entity & entity) {
+                    CB_PROFILE_SPAN(ProfileSpan::Entities, Profiler::GetEntityTypeName(entity.GetEntityType()));
+
+                    // start entity if it hasn't already
+                    entity.Start();
+
+                    // call frame update methods
+                    entity.Update(dt);
+
+                    return false;
+                });
+
+                // scripts with update_all get every entity that was queued above in one call
+                this->scripts.CallBatchedUpdates();
+
+                // fire script delay/interval callbacks that have come due
+                this->timers.Advance(dt * 1000.f);
+
+                // tick animations that don't need the main thread
+                if (this->config->threading.parallel_animation && this->scenes.IsCurrentSceneActive()) {
+                    auto & sprites = this->scenes.current_scene->sprites.sprites;
+                    this->jobs.ParallelFor(sprites.size(), CB_JOBS_ANIMATION_GRAIN,
+                                           [&sprites, dt](size_t begin, size_t end) {
+                                               for (size_t i = begin; i < end; i++) {
+                                                   sprites[i]->AnimateConcurrently(dt);
+                                               }
+                                           });
+                }
+            }
 
             // resolve collision events
-            EngineEventQueue::GetInstance().ExecuteCollision();
+            {
+                CB_PROFILE_PHASE(ProfilePhase::Collision);
+                EngineEventQueue::GetInstance().ExecuteCollision();
+            }
 
             // timing update
             this->counters.Updated();
         }
+        this->counters.UpdatesFinished();
+        {
+            const PoolAllocator::Stats & heap = this->scripts.GetHeapStats();
+            this->counters.SampledScriptHeap(heap.live_bytes, heap.peak_bytes, heap.allocations);
+        }
 
         // Render pass
-        if (this->scenes.IsCurrentSceneActive() && this->scenes.current_scene->HasTilemap()) {
-            SDL_Color bg_color = this->scenes.current_scene->GetTilemap()->bg_color;
-            SDL_SetRenderDrawColor(this->renderer, bg_color.r, bg_color.g, bg_color.b, bg_color.a);
-        } else {
-            SDL_SetRenderDrawColor(this->renderer, 0, 0, 0, 0);
-        }
-        SDL_RenderClear(this->renderer);
-        SDL_RenderSetScale(this->renderer, this->config->rendering.scale, this->config->rendering.scale);
-
-        // render all active entities
-        for (auto z_index : {ZIndex::Background, ZIndex::Midground, ZIndex::Foreground}) {
-            this->IterateActiveEntities([this, z_index](std::shared_ptr<Entity> entity) {
-                if (entity->dim.intersects(this->viewport->dim)) {
-                    CB_ViewClippingInfo clip = this->viewport->GetViewableRect(entity->dim, z_index);
-                    entity->Render(this->renderer, clip);
-                    if (z_index == ZIndex::Background) {
-                        // guard is to make sure we only count each entity rendered once per frame
-                        this->counters.RenderedEntity();
-                    }
-                }
-                if (z_index == ZIndex::Background) {
-                    this->counters.CountedEntity();
+        if (render) {
+            CB_PROFILE_PHASE(ProfilePhase::Render);
+            this->counters.RenderStarted();
+            if (this->scenes.IsCurrentSceneActive() && this->scenes.current_scene->HasTilemap()) {
+                SDL_Color bg_color = this->scenes.current_scene->GetTilemap()->bg_color;
+                SDL_SetRenderDrawColor(this->renderer, bg_color.r, bg_color.g, bg_color.b, bg_color.a);
+            } else {
+                SDL_SetRenderDrawColor(this->renderer, 0, 0, 0, 0);
+            }
+            SDL_RenderClear(this->renderer);
+            SDL_RenderSetScale(this->renderer, this->config->rendering.scale, this->config->rendering.scale);
+
+            // cull and bucket world entities once, then draw them back to front
+            this->render_list.Build(this->scenes.IsCurrentSceneActive() ? this->scenes.current_scene.get() : nullptr,
+                                    *this->viewport, this->config->debug.draw_map_regions);
+            this->render_list.Render(this->renderer);
+
+            // finally render GUI on top of everything else
+            CB_Rect gui_view{0, 0, this->viewport->dim.w, this->viewport->dim.h};
+            this->IterateActiveGuiPanels([this, &gui_view](Gui::GuiPanel & panel) {
+                if (panel.dim.intersects(gui_view)) {
+                    CB_ViewClippingInfo clip = this->viewport->GetStaticViewableRect(panel.dim, ZIndex::Gui);
+                    panel.Render(this->renderer, clip);
                 }
                 return false;
             });
-        }
 
-        // finally render GUI on top of everything else
-        CB_Rect gui_view{0, 0, this->viewport->dim.w, this->viewport->dim.h};
-        this->IterateActiveGuiPanels([this, &gui_view](std::shared_ptr<Gui::GuiPanel> panel) {
-            if (panel->dim.intersects(gui_view)) {
-                CB_ViewClippingInfo clip = this->viewport->GetStaticViewableRect(panel->dim, ZIndex::Gui);
-                panel->Render(this->renderer, clip);
+            if (this->config->debug.draw_info_pane) {
+                SDL_RenderSetScale(this->renderer, 1.0f, 1.0f);
+                this->RenderDebugPane();
             }
-            return false;
-        });
-
-        if (this->config->debug.draw_info_pane) {
-            SDL_RenderSetScale(this->renderer, 1.0f, 1.0f);
-            this->RenderDebugPane();
         }
-        SDL_RenderPresent(this->renderer);
+        if (render) {
+            CB_PROFILE_PHASE(ProfilePhase::Present);
+            SDL_RenderPresent(this->renderer);
+            this->counters.RenderFinished();
+        }
 
         // Clean up entities that were marked for deletion
-        this->DestroyMarkedEntities();
+        {
+            CB_PROFILE_PHASE(ProfilePhase::DestroyEntities);
+            this->DestroyMarkedEntities();
+        }
+
+        // stop once the requested number of updates has been simulated
+        if (this->config->headless.ticks > 0 && this->counters.GetUpdateCount() >= this->config->headless.ticks) {
+            quit = true;
+        }
+    }
+
+    if (this->config->headless.enabled) {
+        this->counters.WriteSummary(std::cout);
+    }
+    if (profiler.IsEnabled()) {
+        profiler.WriteChromeTrace(CB_PROFILER_TRACE_FILE);
+    }
+    if (script_profiler.IsEnabled()) {
+        script_profiler.WriteFoldedStacks(CB_SCRIPT_PROFILER_FOLDED_FILE);
     }
 
     LOG_INFO("Exiting Engine::Run()");
@@ -414,21 +450,71 @@ void Engine::RenderDebugPane() {
     std::ostream os(&info);
 
     float mem_mb_current = (float)NadeauSoftware::getCurrentRSS() / 1024.f / 1024.f;
+    float js_mb_live = static_cast<float>(this->counters.GetScriptHeapLiveBytes()) / 1024.f / 1024.f;
+    float js_mb_peak = static_cast<float>(this->counters.GetScriptHeapPeakBytes()) / 1024.f / 1024.f;
 
     os << "view " << this->viewport->dim.xy().to_string();
     os << " | ent " << this->counters.GetRenderedEntitiesCount() << "/" << this->counters.GetTotalEntitiesCount();
+    os << " | coll " << this->counters.GetCollisionPairsTestedCount();
+    os << " | batch " << this->counters.GetSpriteBatchCount();
+    if (this->scenes.IsCurrentSceneActive() && this->scenes.current_scene->HasTilemap()) {
+        os << " | chunks " << this->scenes.current_scene->GetTilemap()->GetBakedChunkCount();
+    }
+    os << " | ev " << this->counters.GetQueuedEventCount() << "/" << this->counters.GetExecutedEventCount();
     os << " | " << std::fixed << std::setprecision(1) << this->counters.GetAverageFps() << " fps";
     os << " | " << std::fixed << std::setprecision(2) << mem_mb_current << " MB";
+    os << " | js " << js_mb_live << "/" << js_mb_peak << " MB " << this->counters.GetScriptAllocationsPerFrame()
+       << " alloc";
+
+    std::vector<std::string> lines{info.str()};
 
-    roundedBoxRGBA(this->renderer, -6, this->config->window.height - 12, info.str().length() * 8 + 10,
-                   this->config->window.height + 6, 6, 0, 0, 0, 127);
-    stringRGBA(this->renderer, 2, this->config->window.height - 10, info.str().c_str(), 255, 255, 255, 255);
+    // rolling frame/update/render timings
+    std::stringbuf timings;
+    std::ostream tos(&timings);
+    auto write_stats = [&tos](const char * name, const TimingSamples::Stats & stats) {
+        tos << name << " " << stats.p50 << "/" << stats.p95 << "/" << stats.p99 << "/" << stats.max;
+    };
+    tos << std::fixed << std::setprecision(1) << "ms p50/95/99/max | ";
+    write_stats("frame", this->counters.GetFrameTimeStats());
+    tos << " | ";
+    write_stats("upd", this->counters.GetUpdateTimeStats());
+    tos << " | ";
+    write_stats("rnd", this->counters.GetRenderTimeStats());
+    lines.push_back(timings.str());
+
+    // previous frame's time per engine phase
+    if (Profiler::GetInstance().IsEnabled()) {
+        std::stringbuf phases;
+        std::ostream pos(&phases);
+        pos << std::fixed << std::setprecision(2) << "ms";
+        for (int i = 0; i < CB_PROFILE_PHASE_COUNT; i++) {
+            ProfilePhase phase = static_cast<ProfilePhase>(i);
+            pos << " | " << Profiler::GetPhaseName(phase) << " " << Profiler::GetInstance().GetPhaseTime(phase);
+        }
+        lines.push_back(phases.str());
+    }
+
+    // previous frame's busiest script entry points
+    if (this->scripts.GetProfiler().IsEnabled()) {
+        std::stringbuf script_times;
+        std::ostream sos(&script_times);
+        this->scripts.GetProfiler().WriteFrameSummary(sos, CB_SCRIPT_PROFILER_PANE_ENTRIES);
+        lines.push_back(script_times.str());
+    }
+
+    // lines stack upwards from the bottom of the window
+    int line_y = this->config->window.height;
+    for (auto & line : lines) {
+        roundedBoxRGBA(this->renderer, -6, line_y - 12, line.length() * 8 + 10, line_y + 6, 6, 0, 0, 0, 127);
+        stringRGBA(this->renderer, 2, line_y - 10, line.c_str(), 255, 255, 255, 255);
+        line_y -= 12;
+    }
 }
 
 void Engine::SetConfiguration(std::shared_ptr<EngineConfiguration> config) { this->config = std::move(config); }
 
 void Engine::SetWindowIcon() {
-    if (!this->config->window.icon_path.empty()) {
+    if (this->window != nullptr && !this->config->window.icon_path.empty()) {
         std::shared_ptr<SDL_Surface> icon = this->config->loader->GetImageResourceAsSurface(this->config->window.icon_path);
         if (icon != nullptr) {
             SDL_SetWindowIcon(this->window, icon.get());
@@ -76,6 +76,11 @@ bool EngineConfiguration::ReloadConfiguration() {
             this->debug.draw_info_pane = config.GetTableBool("debug.draw_info_pane", this->debug.draw_info_pane);
             this->debug.draw_map_regions = config.GetTableBool("debug.draw_map_regions", this->debug.draw_map_regions);
             this->debug.draw_sprite_rects = config.GetTableBool("debug.draw_sprite_rects", this->debug.draw_sprite_rects);
+            this->debug.profile = config.GetTableBool("debug.profile", this->debug.profile);
+            this->debug.profile_entities = config.GetTableBool("debug.profile_entities", this->debug.profile_entities);
+            this->debug.profile_script_sampling =
+                config.GetTableBool("debug.profile_script_sampling", this->debug.profile_script_sampling);
+            this->debug.profile_scripts = config.GetTableBool("debug.profile_scripts", this->debug.profile_scripts);
 
             // input
             this->input.controller = config.GetTableBool("input.controller", this->input.controller);
@@ -85,6 +90,21 @@ bool EngineConfiguration::ReloadConfiguration() {
             // render seettings
             this->rendering.scale = config.GetTableFloat("rendering.scale", this->rendering.scale);
 
+            // scripting
+            this->scripting.heap_limit_kb =
+                config.GetTableInt("scripting.heap_limit_kb", this->scripting.heap_limit_kb);
+
+            // threading
+            this->threading.parallel_animation =
+                config.GetTableBool("threading.parallel_animation", this->threading.parallel_animation);
+            this->threading.parallel_colliders =
+                config.GetTableBool("threading.parallel_colliders", this->threading.parallel_colliders);
+            this->threading.parallel_culling =
+                config.GetTableBool("threading.parallel_culling", this->threading.parallel_culling);
+            this->threading.parallel_tilemap =
+                config.GetTableBool("threading.parallel_tilemap", this->threading.parallel_tilemap);
+            this->threading.workers = config.GetTableInt("threading.workers", this->threading.workers);
+
             // window settings
             this->window.full_screen = config.GetTableBool("window.full_screen", this->window.full_screen);
             this->window.height = config.GetTableInt("window.height", this->window.height);
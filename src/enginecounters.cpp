@@ -1,41 +1,171 @@
 #include <algorithm>
+#include <cmath>
+#include <vector>
 
 #include <cb/critterbits.hpp>
 
 namespace Critterbits {
-void EngineCounters::CountedEntity() { this->entity_count++; }
+void TimingSamples::AddSample(float sample) {
+    this->samples[this->next] = sample;
+    this->next = (this->next + 1) % CB_TIMING_SAMPLE_COUNT;
+    this->count = std::min(this->count + 1, static_cast<size_t>(CB_TIMING_SAMPLE_COUNT));
+}
+
+float TimingSamples::GetMean() const {
+    if (this->count == 0) {
+        return 0.f;
+    }
+    float total = 0.f;
+    for (size_t i = 0; i < this->count; i++) {
+        total += this->samples[i];
+    }
+    return total / this->count;
+}
+
+TimingSamples::Stats TimingSamples::GetStats() const {
+    Stats stats;
+    if (this->count > 0) {
+        std::vector<float> sorted{this->samples, this->samples + this->count};
+        std::sort(sorted.begin(), sorted.end());
+        // nearest-rank percentiles
+        auto percentile = [&sorted](float p) {
+            size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+            return sorted[std::max(rank, static_cast<size_t>(1)) - 1];
+        };
+        stats.p50 = percentile(0.50f);
+        stats.p95 = percentile(0.95f);
+        stats.p99 = percentile(0.99f);
+        stats.max = sorted.back();
+    }
+    return stats;
+}
 
-float EngineCounters::GetDeltaFromRemainingFrameTime() {
-    return std::min(this->delta_time, this->frame_time / 1000.0f);
+void TimingSamples::Reset() {
+    this->count = 0;
+    this->next = 0;
+}
+
+void EngineCounters::CountedEntity(unsigned int count) { this->entity_count += count; }
+
+void EngineCounters::ExecutedEvents(unsigned int count) { this->executed_event_count += count; }
+
+float EngineCounters::GetAverageFps() const {
+    float mean_frame_time = this->frame_times.GetMean();
+    return mean_frame_time > 0.f ? 1000.0f / mean_frame_time : 0.f;
+}
+
+float EngineCounters::GetDeltaFromRemainingFrameTime() { return std::min(this->delta_time, this->frame_time); }
+
+float EngineCounters::GetMillisecondsSince(Uint64 counter) const {
+    return static_cast<float>((SDL_GetPerformanceCounter() - counter) * 1000.0 / this->counter_frequency);
 }
 
 void EngineCounters::NewFrame() {
-    this->ticks = SDL_GetTicks();
-    this->frame_time = this->ticks - this->last_ticks;
-    this->last_ticks = this->ticks;
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (this->frame_count == 0) {
+        // nothing to measure the first frame against, just run a single update
+        this->start_counter = now;
+        this->frame_time = this->delta_time;
+    } else {
+        float elapsed = static_cast<float>((now - this->last_counter) * 1000.0 / this->counter_frequency);
+        this->frame_times.AddSample(elapsed);
+        // exactly one update per frame in fixed step mode, regardless of how much wall clock time went by
+        this->frame_time = this->fixed_step ? this->delta_time : elapsed / 1000.0f;
+    }
+    this->last_counter = now;
     this->frame_count++;
     this->render_count = 0;
     this->entity_count = 0;
-    if (this->frame_count % 10 == 0) {
-        this->fps = (this->fps + 1000.0f / this->frame_time) / 2.0f;
-    }
+    this->collision_pair_count = 0;
+    this->sprite_batch_count = 0;
+    this->queued_event_count = 0;
+    this->executed_event_count = 0;
 }
 
-void EngineCounters::RenderedEntity() { this->render_count++; }
+void EngineCounters::QueuedEvent() { this->queued_event_count++; }
+
+void EngineCounters::RenderedEntity(unsigned int count) { this->render_count += count; }
+
+void EngineCounters::RenderFinished() { this->render_times.AddSample(this->GetMillisecondsSince(this->phase_counter)); }
+
+void EngineCounters::RenderStarted() { this->phase_counter = SDL_GetPerformanceCounter(); }
 
 void EngineCounters::Reset() {
-    this->fps = 0.;
-    this->ticks = 0;
-    this->last_ticks = 0;
-    this->frame_time = 0;
+    this->counter_frequency = SDL_GetPerformanceFrequency();
+    this->start_counter = 0;
+    this->last_counter = 0;
+    this->phase_counter = 0;
+    this->frame_time = 0.f;
     this->frame_count = 0;
     this->entity_count = 0;
     this->render_count = 0;
     this->update_count = 0;
+    this->collision_pair_count = 0;
+    this->sprite_batch_count = 0;
+    this->queued_event_count = 0;
+    this->executed_event_count = 0;
+    this->script_heap_live = 0;
+    this->script_heap_peak = 0;
+    this->script_allocations = 0;
+    this->script_frame_allocations = 0;
+    this->frame_times.Reset();
+    this->update_times.Reset();
+    this->render_times.Reset();
 }
 
+void EngineCounters::SampledScriptHeap(size_t live_bytes, size_t peak_bytes, unsigned long long allocations) {
+    // allocations is the allocator's running total, the difference since the last sample is this frame's share
+    this->script_frame_allocations = allocations - std::min(this->script_allocations, allocations);
+    this->script_heap_live = live_bytes;
+    this->script_heap_peak = peak_bytes;
+    this->script_allocations = allocations;
+}
+
+void EngineCounters::SubmittedSpriteBatch() { this->sprite_batch_count++; }
+
+void EngineCounters::TestedCollisionPair() { this->collision_pair_count++; }
+
 void EngineCounters::Updated() {
     this->update_count++;
-    this->frame_time -= this->delta_time * 1000;
+    this->frame_time -= this->delta_time;
+    // leftover slivers under a millisecond aren't worth an update of their own
+    if (this->fixed_step || this->frame_time < 0.001f) {
+        this->frame_time = 0.f;
+    }
+}
+
+void EngineCounters::UpdatesFinished() {
+    this->update_times.AddSample(this->GetMillisecondsSince(this->phase_counter));
+}
+
+void EngineCounters::UpdatesStarted() { this->phase_counter = SDL_GetPerformanceCounter(); }
+
+void EngineCounters::WriteSummary(std::ostream & os) {
+    float run_time = this->GetMillisecondsSince(this->start_counter);
+    os << "frames " << this->frame_count << std::endl;
+    os << "updates " << this->update_count << std::endl;
+    os << "run_time_ms " << run_time << std::endl;
+    if (run_time > 0.f) {
+        os << "frames_per_sec " << this->frame_count * 1000.0f / run_time << std::endl;
+        os << "updates_per_sec " << this->update_count * 1000.0f / run_time << std::endl;
+        os << "script_allocations_per_sec " << this->script_allocations * 1000.0f / run_time << std::endl;
+    }
+    auto write_stats = [&os](const char * name, const TimingSamples::Stats & stats) {
+        os << name << "_ms p50 " << stats.p50 << " p95 " << stats.p95 << " p99 " << stats.p99 << " max " << stats.max
+           << std::endl;
+    };
+    write_stats("frame", this->frame_times.GetStats());
+    write_stats("update", this->update_times.GetStats());
+    write_stats("render", this->render_times.GetStats());
+    os << "last_frame_entities " << this->entity_count << std::endl;
+    os << "last_frame_rendered " << this->render_count << std::endl;
+    os << "last_frame_collision_pairs " << this->collision_pair_count << std::endl;
+    os << "last_frame_sprite_batches " << this->sprite_batch_count << std::endl;
+    os << "last_frame_events_queued " << this->queued_event_count << std::endl;
+    os << "last_frame_events_executed " << this->executed_event_count << std::endl;
+    os << "last_frame_script_allocations " << this->script_frame_allocations << std::endl;
+    os << "script_allocations " << this->script_allocations << std::endl;
+    os << "script_heap_live_bytes " << this->script_heap_live << std::endl;
+    os << "script_heap_peak_bytes " << this->script_heap_peak << std::endl;
 }
 }
\ No newline at end of file
@@ -3,21 +3,30 @@
 namespace Critterbits {
 
 void EngineEventQueue::ExecuteCollision() {
-    // take a copy of the collision queue in case the events modify it
-    std::vector<CollisionEvent> events = this->collision;
-    this->collision.clear();
-    for (auto event : events) {
-        event();
+    // anything queued by the events themselves goes in the other buffer and runs next time
+    this->collision.swap(this->collision_executing);
+    EntityRegistry & entities = Engine::GetInstance().entities;
+    for (auto & event : this->collision_executing) {
+        // entities are looked up again here, as either one may have been unloaded since the event was queued
+        std::shared_ptr<Entity> entity = entities.Find(event.entity_id);
+        std::shared_ptr<Entity> other_entity = entities.Find(event.other_entity_id);
+        if (entity != nullptr && other_entity != nullptr) {
+            BoxCollider::ResolveCollision(entity, other_entity);
+        }
     }
+    Engine::GetInstance().scripts.CallBatchedCollisions();
+    Engine::GetInstance().counters.ExecutedEvents(this->collision_executing.size());
+    this->collision_executing.clear();
 }
 
 void EngineEventQueue::ExecutePreUpdate() {
-    // take a copy of the pre_update queue in case the events modify it
-    std::vector<PreUpdateEvent> events = this->pre_update;
-    this->pre_update.clear();
-    for (auto event : events) {
+    // anything queued by the events themselves goes in the other buffer and runs next time
+    this->pre_update.swap(this->pre_update_executing);
+    for (auto & event : this->pre_update_executing) {
         event();
     }
+    Engine::GetInstance().counters.ExecutedEvents(this->pre_update_executing.size());
+    this->pre_update_executing.clear();
 }
 
 EngineEventQueue & EngineEventQueue::GetInstance() {
@@ -25,6 +34,13 @@ EngineEventQueue & EngineEventQueue::GetInstance() {
     return instance;
 }
 
-void EngineEventQueue::QueueCollision(const CollisionEvent event) { this->collision.push_back(event); }
-void EngineEventQueue::QueuePreUpdate(const PreUpdateEvent event) { this->pre_update.push_back(event); }
+void EngineEventQueue::QueueCollision(const CollisionEvent & event) {
+    this->collision.push_back(event);
+    Engine::GetInstance().counters.QueuedEvent();
+}
+
+void EngineEventQueue::QueuePreUpdate(const PreUpdateEvent event) {
+    this->pre_update.push_back(event);
+    Engine::GetInstance().counters.QueuedEvent();
+}
 }
\ No newline at end of file
@@ -3,6 +3,14 @@
 namespace Critterbits {
 entity_id_t next_entity_id = CB_ENTITY_ID_FIRST;
 
+void Entity::MarkDestroy() {
+    // queue for destruction at the end of the frame, rather than having the engine look for destroyed entities
+    if (!this->destroyed) {
+        this->destroyed = true;
+        Engine::GetInstance().QueueDestroy(shared_from_this());
+    }
+}
+
 void Entity::Render(SDL_Renderer * renderer, const CB_ViewClippingInfo & clip_rect) {
     if (this->IsActive()) {
         this->OnRender(renderer, clip_rect);
@@ -12,6 +20,11 @@ void Entity::Render(SDL_Renderer * renderer, const CB_ViewClippingInfo & clip_re
     }
 }
 
+bool Entity::RenderBatched(SpriteBatch & batch, const CB_ViewClippingInfo & clip_rect) {
+    // entities that can't batch this layer fall back to Render()
+    return this->IsActive() && this->OnRenderBatched(batch, clip_rect);
+}
+
 void Entity::Start() {
     if (!this->started) {
         if (this->OnStart()) {
@@ -28,7 +41,16 @@ void Entity::Update(float delta_time) {
     if (this->IsActive() && this->time_scale != 0.f) {
         float scaled_delta_time = delta_time * this->time_scale;
         if (this->HasScript()) {
-            this->script->CallUpdate(shared_from_this(), scaled_delta_time);
+            if (this->callbacks_paused) {
+                // running again, put the callbacks that were parked while it was paused back on the wheel
+                this->script->RescheduleCallbacks(*this);
+            }
+            if (this->script->HasBatchedUpdate()) {
+                // the engine calls update_all once for every entity queued this frame
+                this->script->QueueUpdate(shared_from_this(), scaled_delta_time);
+            } else {
+                this->script->CallUpdate(shared_from_this(), scaled_delta_time);
+            }
         }
         this->OnUpdate(scaled_delta_time);
     }
@@ -0,0 +1,73 @@
+#include <cb/critterbits.hpp>
+
+namespace Critterbits {
+void EntityRegistry::Clear() {
+    this->entities.clear();
+    for (auto & tagged : this->tagged_entities) {
+        tagged.clear();
+    }
+}
+
+std::shared_ptr<Entity> EntityRegistry::Find(entity_id_t entity_id) const {
+    auto it = this->entities.find(entity_id);
+    if (it != this->entities.end()) {
+        return it->second.entity.lock();
+    }
+    return nullptr;
+}
+
+void EntityRegistry::FindByTag(const std::string & tag, std::vector<std::shared_ptr<Entity>> * found) const {
+    auto tag_id = this->tag_ids.find(tag);
+    if (tag_id == this->tag_ids.end()) {
+        return;
+    }
+    for (auto & tagged : this->tagged_entities[tag_id->second]) {
+        if (auto entity = tagged.entity.lock()) {
+            found->push_back(std::move(entity));
+        }
+    }
+}
+
+EntityRegistry::tag_id_t EntityRegistry::InternTag(const std::string & tag) {
+    auto it = this->tag_ids.find(tag);
+    if (it != this->tag_ids.end()) {
+        return it->second;
+    }
+    tag_id_t tag_id = static_cast<tag_id_t>(this->tagged_entities.size());
+    this->tag_ids.emplace(tag, tag_id);
+    this->tagged_entities.emplace_back();
+    return tag_id;
+}
+
+void EntityRegistry::Register(std::shared_ptr<Entity> entity) {
+    if (entity == nullptr) {
+        return;
+    }
+    if (this->entities.find(entity->entity_id) != this->entities.end()) {
+        this->Unregister(entity->entity_id);
+    }
+
+    // untagged entities are indexed too (under the empty tag) so every record has a valid slot
+    tag_id_t tag_id = this->InternTag(entity->tag);
+    std::vector<TaggedEntity> & tagged = this->tagged_entities[tag_id];
+    this->entities[entity->entity_id] = RegisteredEntity{entity, tag_id, tagged.size()};
+    tagged.push_back(TaggedEntity{entity->entity_id, entity});
+}
+
+void EntityRegistry::Unregister(entity_id_t entity_id) {
+    auto it = this->entities.find(entity_id);
+    if (it == this->entities.end()) {
+        return;
+    }
+
+    // swap the last entity with this tag into the vacated slot
+    std::vector<TaggedEntity> & tagged = this->tagged_entities[it->second.tag_id];
+    size_t index = it->second.tag_index;
+    if (index != tagged.size() - 1) {
+        tagged[index] = std::move(tagged.back());
+        this->entities[tagged[index].entity_id].tag_index = index;
+    }
+    tagged.pop_back();
+    this->entities.erase(it);
+}
+}
\ No newline at end of file
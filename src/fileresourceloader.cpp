@@ -41,6 +41,11 @@ std::shared_ptr<SDL_Surface> FileResourceLoader::GetImageResourceAsSurface(const
     return std::move(surface_ptr);
 }
 
+bool FileResourceLoader::GetScriptBytecode(const std::string &, unsigned long, std::string **) const {
+    // scripts are only precompiled when they're packed
+    return false;
+}
+
 bool FileResourceLoader::GetTextResourceContents(const std::string & asset_path, std::string ** text_content) const {
     std::ifstream ifs;
 
@@ -185,6 +185,10 @@ std::shared_ptr<GuiPanel> GuiManager::OpenPanel(const std::string & panel_name,
     std::shared_ptr<GuiPanel> panel = this->LoadGuiPanel(panel_name);
     if (panel != nullptr) {
         this->panels.push_back(panel);
+        Engine::GetInstance().entities.Register(panel);
+        for (auto & control : panel->children) {
+            Engine::GetInstance().entities.Register(control);
+        }
         EngineEventQueue::GetInstance().QueuePreUpdate([panel]() {
             CB_Rect viewport_bounds = Engine::GetInstance().viewport->dim;
             viewport_bounds.x = 0;
@@ -200,6 +204,12 @@ std::shared_ptr<GuiPanel> GuiManager::OpenPanel(const std::string & panel_name,
 void GuiManager::UnloadPanel(std::shared_ptr<GuiPanel> panel) {
     if (panel != nullptr) {
         panel->state = EntityState::Unloaded;
+        Engine::GetInstance().entities.Unregister(panel->entity_id);
+        Engine::GetInstance().scripts.ReleaseEntity(panel->entity_id);
+        for (auto & control : panel->children) {
+            Engine::GetInstance().entities.Unregister(control->entity_id);
+            Engine::GetInstance().scripts.ReleaseEntity(control->entity_id);
+        }
         for (auto it = this->panels.begin(); it != this->panels.end(); it++) {
             if (*it == panel) {
                 this->panels.erase(it);
@@ -0,0 +1,145 @@
+#include <algorithm>
+
+#include <cb/critterbits.hpp>
+
+namespace Critterbits {
+namespace {
+// index of the queue owned by the current thread, the main thread (and any other thread) uses queue 0
+thread_local unsigned int current_queue_index = 0;
+}
+
+JobSystem::~JobSystem() { this->Stop(); }
+
+bool JobSystem::PopJob(unsigned int queue_index, JobEntry * entry) {
+    // newest job from our own queue first, it is the most likely to still be in cache
+    {
+        JobQueue & own = *this->queues[queue_index];
+        std::lock_guard<std::mutex> lock{own.mutex};
+        if (!own.jobs.empty()) {
+            *entry = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+
+    // otherwise steal the oldest job from someone else
+    for (size_t i = 1; i < this->queues.size(); i++) {
+        JobQueue & victim = *this->queues[(queue_index + i) % this->queues.size()];
+        std::lock_guard<std::mutex> lock{victim.mutex};
+        if (!victim.jobs.empty()) {
+            *entry = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobSystem::RunOneJob() {
+    JobEntry entry;
+    if (this->queues.empty() || !this->PopJob(current_queue_index, &entry)) {
+        return false;
+    }
+    this->queued_jobs--;
+    entry.job();
+    if (entry.counter != nullptr) {
+        entry.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+    return true;
+}
+
+void JobSystem::Schedule(Job job, JobCounter * counter) {
+    if (counter != nullptr) {
+        counter->pending.fetch_add(1, std::memory_order_acq_rel);
+    }
+    if (!this->running) {
+        job();
+        if (counter != nullptr) {
+            counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+        }
+        return;
+    }
+
+    {
+        JobQueue & own = *this->queues[current_queue_index];
+        std::lock_guard<std::mutex> lock{own.mutex};
+        own.jobs.push_back(JobEntry{std::move(job), counter});
+    }
+    this->queued_jobs++;
+    {
+        // workers test queued_jobs under this lock before sleeping, so taking it here can't lose the wakeup
+        std::lock_guard<std::mutex> lock{this->wake_mutex};
+    }
+    this->wake.notify_one();
+}
+
+bool JobSystem::Start(int worker_count) {
+    if (this->running) {
+        this->Stop();
+    }
+    if (worker_count < 0) {
+        // leave a core for the main thread
+        worker_count = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    }
+    worker_count = std::min(worker_count, CB_JOBS_MAX_WORKERS);
+    if (worker_count <= 0) {
+        LOG_INFO("JobSystem::Start no worker threads, jobs will run on the main thread");
+        return false;
+    }
+
+    for (int i = 0; i <= worker_count; i++) {
+        this->queues.emplace_back(new JobQueue());
+    }
+    this->running = true;
+    for (int i = 1; i <= worker_count; i++) {
+        this->workers.emplace_back(&JobSystem::WorkerMain, this, static_cast<unsigned int>(i));
+    }
+    LOG_INFO("JobSystem::Start started " + std::to_string(worker_count) + " worker thread(s)");
+    return true;
+}
+
+void JobSystem::Stop() {
+    if (!this->running) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock{this->wake_mutex};
+        this->running = false;
+    }
+    this->wake.notify_all();
+    for (auto & worker : this->workers) {
+        worker.join();
+    }
+    this->workers.clear();
+
+    // anything still queued was never waited on, but run it anyway so counters don't dangle
+    for (auto & queue : this->queues) {
+        for (auto & entry : queue->jobs) {
+            entry.job();
+            if (entry.counter != nullptr) {
+                entry.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        }
+    }
+    this->queues.clear();
+    this->queued_jobs = 0;
+}
+
+void JobSystem::Wait(JobCounter & counter) {
+    while (!counter.IsDone()) {
+        if (!this->RunOneJob()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::WorkerMain(unsigned int queue_index) {
+    current_queue_index = queue_index;
+    while (this->running) {
+        if (!this->RunOneJob()) {
+            std::unique_lock<std::mutex> lock{this->wake_mutex};
+            this->wake.wait(lock, [this]() { return !this->running || this->queued_jobs > 0; });
+        }
+    }
+}
+}
\ No newline at end of file
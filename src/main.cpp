@@ -1,20 +1,71 @@
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
 #include <string>
 
 #include <cb/critterbits.hpp>
 
 using namespace Critterbits;
 
+namespace {
+int Usage(const std::string & program, const std::string & error) {
+    std::cerr << "[ERROR] " << error << std::endl;
+    std::cerr << "usage: " << program
+              << " [--headless] [--realtime] [--no-render] [--ticks N] [--scene NAME] [asset_path]" << std::endl;
+    return 1;
+}
+}
+
 int main(int argc, char ** argv) {
-    // determine asset path and load configuration
+    // determine asset path and run options
     std::string asset_path = CB_DEFAULT_ASSET_PATH;
-    if (argc > 1) {
-        asset_path = std::string(argv[1]);
+    bool headless = false;
+    bool realtime = false;
+    bool render = true;
+    unsigned int ticks = 0;
+    std::string first_scene = CB_FIRST_SCENE;
+    for (int i = 1; i < argc; i++) {
+        std::string arg{argv[i]};
+        if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--realtime") {
+            realtime = true;
+        } else if (arg == "--no-render") {
+            render = false;
+        } else if (arg == "--ticks") {
+            char * end = nullptr;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                ticks = static_cast<unsigned int>(std::strtoul(argv[++i], &end, 10));
+            }
+            if (end == nullptr || *end != '\0') {
+                return Usage(argv[0], "--ticks needs a number of ticks");
+            }
+        } else if (arg == "--scene") {
+            if (i + 1 >= argc || argv[i + 1][0] == '\0' || argv[i + 1][0] == '-') {
+                return Usage(argv[0], "--scene needs a scene name");
+            }
+            first_scene = argv[++i];
+        } else if (!arg.empty() && arg[0] == '-') {
+            return Usage(argv[0], "unknown option " + arg);
+        } else {
+            asset_path = arg;
+        }
+    }
+
+    // headless runs use SDL's dummy video driver, which has to be picked before SDL is initialized
+    if (headless) {
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
     }
     std::shared_ptr<EngineConfiguration> config = std::make_shared<EngineConfiguration>(asset_path);
+    config->headless.enabled = headless;
+    config->headless.realtime = realtime;
+    config->headless.render = render;
+    config->headless.ticks = ticks;
+    config->first_scene = first_scene;
 
     // assign configuration to engine
     Engine::GetInstance().SetConfiguration(std::move(config));
 
-    // run (blocks until window closed)
+    // run (blocks until window closed, or the requested number of ticks has run)
     return Engine::GetInstance().Run();
 }
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include <cstdlib>
+#include <cstring>
+
+#include <cb/memory/poolallocator.hpp>
+
+namespace Critterbits {
+namespace {
+const size_t size_classes[CB_POOL_SIZE_CLASS_COUNT]{16, 32, 48, 64, 96, 128, 192, 256, 384, CB_POOL_MAX_POOLED_SIZE};
+
+// keeps the payload after the header aligned for any type
+union BlockHeader {
+    size_t size;
+    std::max_align_t align;
+};
+
+inline BlockHeader * GetHeader(void * ptr) { return reinterpret_cast<BlockHeader *>(ptr) - 1; }
+}
+
+PoolAllocator::~PoolAllocator() {
+    for (char * chunk : this->chunks) {
+        std::free(chunk);
+    }
+}
+
+void * PoolAllocator::Allocate(size_t size) {
+    if (this->IsOverLimit(size)) {
+        this->stats.failed_allocations++;
+        return nullptr;
+    }
+
+    int size_class = GetSizeClass(size);
+    char * block = nullptr;
+    if (size_class < 0) {
+        block = static_cast<char *>(std::malloc(sizeof(BlockHeader) + size));
+        if (block != nullptr) {
+            this->stats.reserved_bytes += sizeof(BlockHeader) + size;
+        }
+    } else if (this->free_lists[size_class] != nullptr) {
+        FreeBlock * free_block = this->free_lists[size_class];
+        this->free_lists[size_class] = free_block->next;
+        block = reinterpret_cast<char *>(free_block);
+    } else {
+        block = this->AllocateBlock(size_class);
+    }
+    if (block == nullptr) {
+        this->stats.failed_allocations++;
+        return nullptr;
+    }
+
+    reinterpret_cast<BlockHeader *>(block)->size = size;
+    this->stats.allocations++;
+    this->stats.live_bytes += size;
+    if (this->stats.live_bytes > this->stats.peak_bytes) {
+        this->stats.peak_bytes = this->stats.live_bytes;
+    }
+    return block + sizeof(BlockHeader);
+}
+
+char * PoolAllocator::AllocateBlock(int size_class) {
+    size_t block_size = sizeof(BlockHeader) + size_classes[size_class];
+    if (this->chunk_next == nullptr || static_cast<size_t>(this->chunk_end - this->chunk_next) < block_size) {
+        // whatever is left at the end of the old chunk is too small for this class and simply goes unused
+        char * chunk = static_cast<char *>(std::malloc(CB_POOL_CHUNK_SIZE));
+        if (chunk == nullptr) {
+            return nullptr;
+        }
+        this->chunks.push_back(chunk);
+        this->chunk_next = chunk;
+        this->chunk_end = chunk + CB_POOL_CHUNK_SIZE;
+        this->stats.reserved_bytes += CB_POOL_CHUNK_SIZE;
+    }
+    char * block = this->chunk_next;
+    this->chunk_next += block_size;
+    return block;
+}
+
+void PoolAllocator::Free(void * ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    BlockHeader * header = GetHeader(ptr);
+    size_t size = header->size;
+    this->stats.live_bytes -= size;
+
+    int size_class = GetSizeClass(size);
+    if (size_class < 0) {
+        this->stats.reserved_bytes -= sizeof(BlockHeader) + size;
+        std::free(header);
+    } else {
+        FreeBlock * free_block = reinterpret_cast<FreeBlock *>(header);
+        free_block->next = this->free_lists[size_class];
+        this->free_lists[size_class] = free_block;
+    }
+}
+
+int PoolAllocator::GetSizeClass(size_t size) {
+    if (size > CB_POOL_MAX_POOLED_SIZE) {
+        return -1;
+    }
+    for (int i = 0; i < CB_POOL_SIZE_CLASS_COUNT; i++) {
+        if (size <= size_classes[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool PoolAllocator::IsOverLimit(size_t size) const {
+    return this->stats.limit_bytes > 0 && this->stats.live_bytes + size > this->stats.limit_bytes;
+}
+
+void * PoolAllocator::Reallocate(void * ptr, size_t size) {
+    if (ptr == nullptr) {
+        return this->Allocate(size);
+    }
+    if (size == 0) {
+        this->Free(ptr);
+        return nullptr;
+    }
+
+    BlockHeader * header = GetHeader(ptr);
+    size_t old_size = header->size;
+    int size_class = GetSizeClass(old_size);
+    if (size_class >= 0 && size_class == GetSizeClass(size)) {
+        // still fits the block it's in
+        if (size > old_size && this->IsOverLimit(size - old_size)) {
+            this->stats.failed_allocations++;
+            return nullptr;
+        }
+        header->size = size;
+        this->stats.live_bytes = this->stats.live_bytes - old_size + size;
+        if (this->stats.live_bytes > this->stats.peak_bytes) {
+            this->stats.peak_bytes = this->stats.live_bytes;
+        }
+        return ptr;
+    }
+
+    void * new_ptr = this->Allocate(size);
+    if (new_ptr == nullptr) {
+        // the original block is left untouched, as realloc() would
+        return nullptr;
+    }
+    std::memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+    this->Free(ptr);
+    return new_ptr;
+}
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include <fstream>
+
+#include <cb/critterbits.hpp>
+
+namespace Critterbits {
+namespace {
+const char * phase_names[CB_PROFILE_PHASE_COUNT] = {"poll", "input",  "upload",  "pre",    "update",
+                                                    "coll", "render", "present", "destroy"};
+
+std::atomic<unsigned int> next_thread_id{0};
+
+unsigned int GetProfilerThreadId() {
+    static thread_local unsigned int thread_id = next_thread_id++;
+    return thread_id;
+}
+
+void WriteJsonString(std::ostream & os, const char * str) {
+    os << '"';
+    for (const char * c = str; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            os << '\\';
+        }
+        if (static_cast<unsigned char>(*c) >= 0x20) {
+            os << *c;
+        }
+    }
+    os << '"';
+}
+}
+
+Profiler::Profiler() : events(new ProfileEvent[CB_PROFILER_EVENT_CAPACITY]) {
+    this->frequency = SDL_GetPerformanceFrequency();
+    this->start_counter = SDL_GetPerformanceCounter();
+}
+
+const char * Profiler::GetEntityTypeName(EntityType type) {
+    switch (type) {
+        case EntityType::Sprite:
+            return "Sprite";
+        case EntityType::Tilemap:
+            return "Tilemap";
+        case EntityType::TilemapRegion:
+            return "TilemapRegion";
+        case EntityType::Viewport:
+            return "Viewport";
+        case EntityType::GuiPanel:
+            return "GuiPanel";
+        case EntityType::GuiControl:
+            return "GuiControl";
+        default:
+            return "Entity";
+    }
+}
+
+Profiler & Profiler::GetInstance() {
+    static Profiler instance;
+    return instance;
+}
+
+double Profiler::GetPhaseTime(ProfilePhase phase) const {
+    return this->last_phase_counts[static_cast<int>(phase)] * 1000.0 / this->frequency;
+}
+
+const char * Profiler::GetPhaseName(ProfilePhase phase) { return phase_names[static_cast<int>(phase)]; }
+
+const char * Profiler::InternName(const std::string & name) {
+    // names must outlive any events that reference them, so they're kept for the life of the profiler
+    return this->names.insert(name).first->c_str();
+}
+
+void Profiler::NewFrame() {
+    for (int i = 0; i < CB_PROFILE_PHASE_COUNT; i++) {
+        this->last_phase_counts[i] = this->phase_counts[i];
+        this->phase_counts[i] = 0;
+    }
+}
+
+void Profiler::Record(const char * name, Uint64 start, Uint64 end) {
+    size_t index = this->next_event.fetch_add(1, std::memory_order_relaxed);
+    ProfileEvent & event = this->events[index % CB_PROFILER_EVENT_CAPACITY];
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    event.thread_id = GetProfilerThreadId();
+    event.sequence.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::RecordPhase(ProfilePhase phase, Uint64 start, Uint64 end) {
+    // phases are only timed from the main loop, so the per-frame totals don't need to be atomic
+    this->phase_counts[static_cast<int>(phase)] += end - start;
+    this->Record(phase_names[static_cast<int>(phase)], start, end);
+}
+
+void Profiler::SetEnabled(bool enabled, bool entity_spans, bool script_spans) {
+    this->enabled = enabled;
+    this->entity_spans = entity_spans;
+    this->script_spans = script_spans;
+}
+
+bool Profiler::WriteChromeTrace(const std::string & path) const {
+    std::ofstream trace{path, std::ios::out | std::ios::trunc};
+    if (!trace.is_open()) {
+        LOG_ERR("Profiler::WriteChromeTrace unable to open " + path);
+        return false;
+    }
+
+    // only the most recent CB_PROFILER_EVENT_CAPACITY events are still in the buffer
+    size_t last = this->next_event.load(std::memory_order_acquire);
+    size_t first = last > CB_PROFILER_EVENT_CAPACITY ? last - CB_PROFILER_EVENT_CAPACITY : 0;
+    double us_per_count = 1000000.0 / this->frequency;
+    size_t written = 0;
+    trace << "{\"traceEvents\":[";
+    for (size_t i = first; i < last; i++) {
+        const ProfileEvent & event = this->events[i % CB_PROFILER_EVENT_CAPACITY];
+        if (event.sequence.load(std::memory_order_acquire) != i + 1) {
+            // slot was overwritten or hasn't been filled in yet
+            continue;
+        }
+        trace << (written++ > 0 ? ",\n" : "\n") << "{\"name\":";
+        WriteJsonString(trace, event.name);
+        trace << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread_id;
+        trace << ",\"ts\":" << (event.start - this->start_counter) * us_per_count;
+        trace << ",\"dur\":" << (event.end - event.start) * us_per_count << "}";
+    }
+    trace << "\n]}\n";
+
+    LOG_INFO("Profiler::WriteChromeTrace wrote " + std::to_string(written) + " events to " + path);
+    return true;
+}
+}
\ No newline at end of file
@@ -3,62 +3,97 @@
 #include <cb/critterbits.hpp>
 
 namespace Critterbits {
+namespace {
+struct OpenRun {
+    size_t x1;
+    size_t x2;
+    size_t y1;
+};
+
+inline size_t edge_index(const std::vector<int> & edges, int edge) {
+    return std::lower_bound(edges.begin(), edges.end(), edge) - edges.begin();
+}
+}
+
 void RectRegionCombiner::Combine() {
     LOG_INFO("RectRegionCombiner::Combine starting with " + std::to_string(this->regions.size()) +
              " regions to combine");
-    int combines;
 
-    // remove duplicates and completely overlapping rects
-    this->regions.erase(std::unique(this->regions.begin(), this->regions.end(),
-                                    [](const CB_Rect & rect1, const CB_Rect & rect2) {
-                                        // NOTE: need to check this on other STL implementations, as we're relying on the
-                                        // notion that rect1 will be overwritten with rect2 by std::unique. If it's the other
-                                        // way around, the small rect would be preserved instead of the larger one.
-                                        return rect1 == rect2 || rect1.inside(rect2);
-                                    }),
-                        this->regions.end());
+    this->regions.erase(
+        std::remove_if(this->regions.begin(), this->regions.end(), [](const CB_Rect & rect) { return rect.empty(); }),
+        this->regions.end());
+    if (this->regions.empty()) {
+        LOG_INFO("RectRegionCombiner::Combine combined down to 0 regions");
+        return;
+    }
+
+    // rasterize into a grid whose lines are the rects' edges, so rects of any size or alignment cover whole cells
+    // (for tiles this is just the tile grid)
+    std::vector<int> xs, ys;
+    xs.reserve(this->regions.size() * 2);
+    ys.reserve(this->regions.size() * 2);
+    for (auto & rect : this->regions) {
+        xs.push_back(rect.x);
+        xs.push_back(rect.right());
+        ys.push_back(rect.y);
+        ys.push_back(rect.bottom());
+    }
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
 
-    // pre-request some breathing room
-    this->regions.reserve(this->regions.size() * 2);
+    size_t cols = xs.size() - 1;
+    size_t rows = ys.size() - 1;
+    std::vector<bool> covered(cols * rows, false);
+    for (auto & rect : this->regions) {
+        size_t x1 = edge_index(xs, rect.x), x2 = edge_index(xs, rect.right());
+        size_t y1 = edge_index(ys, rect.y), y2 = edge_index(ys, rect.bottom());
+        for (size_t y = y1; y < y2; y++) {
+            std::fill(covered.begin() + y * cols + x1, covered.begin() + y * cols + x2, true);
+        }
+    }
 
-    // brute force!
-    do {
-        combines = 0;
-        for (auto & rect1 : this->regions) {
-            if (rect1.empty())
+    // greedy scanline merge: each row is split into runs of covered cells, and a run spanning exactly the same
+    // columns as one left open by the row above extends it downwards rather than starting a new rect
+    std::vector<CB_Rect> combined;
+    std::vector<OpenRun> open_runs, next_runs;
+    auto close_run = [&combined, &xs, &ys](const OpenRun & run, size_t y2) {
+        combined.emplace_back(xs[run.x1], ys[run.y1], xs[run.x2] - xs[run.x1], ys[y2] - ys[run.y1]);
+    };
+    for (size_t y = 0; y < rows; y++) {
+        size_t open_index = 0;
+        next_runs.clear();
+        for (size_t x = 0; x < cols;) {
+            if (!covered[y * cols + x]) {
+                x++;
                 continue;
-            for (auto & rect2 : this->regions) {
-                if (rect2.empty())
-                    continue;
-                // regions horizontally adjacent
-                if (rect1.y == rect2.y && rect1.h == rect2.h &&
-                    (rect1.x == rect2.right() || rect1.right() == rect2.x)) {
-                    this->regions.emplace_back(std::min(rect1.x, rect2.x), rect1.y, rect1.w + rect2.w, rect1.h);
-                    rect1.w = 0;
-                    rect1.h = 0;
-                    rect2.w = 0;
-                    rect2.h = 0;
-                    combines++;
-                }
-                // regions vertically adjacent
-                if (rect1.x == rect2.x && rect1.w == rect2.w &&
-                    (rect1.y == rect2.bottom() || rect1.bottom() == rect2.y)) {
-                    this->regions.emplace_back(rect1.x, std::min(rect1.y, rect2.y), rect1.w, rect1.h + rect2.h);
-                    rect1.w = 0;
-                    rect1.h = 0;
-                    rect2.w = 0;
-                    rect2.h = 0;
-                    combines++;
-                }
-            } // for rect2
-        }     // for rect1
-    } while (combines > 0);
+            }
+            size_t x1 = x;
+            while (x < cols && covered[y * cols + x]) {
+                x++;
+            }
 
-    this->regions.erase(
-        std::remove_if(this->regions.begin(), this->regions.end(), [](const CB_Rect & rect) { return rect.empty(); }),
-        this->regions.end());
-    this->regions.shrink_to_fit();
+            // open runs starting further left can't continue past this row
+            while (open_index < open_runs.size() && open_runs[open_index].x1 < x1) {
+                close_run(open_runs[open_index++], y);
+            }
+            if (open_index < open_runs.size() && open_runs[open_index].x1 == x1 && open_runs[open_index].x2 == x) {
+                next_runs.push_back(open_runs[open_index++]);
+            } else {
+                next_runs.push_back(OpenRun{x1, x, y});
+            }
+        }
+        while (open_index < open_runs.size()) {
+            close_run(open_runs[open_index++], y);
+        }
+        std::swap(open_runs, next_runs);
+    }
+    for (auto & run : open_runs) {
+        close_run(run, rows);
+    }
 
+    this->regions = std::move(combined);
     LOG_INFO("RectRegionCombiner::Combine combined down to " + std::to_string(this->regions.size()) + " regions");
 }
 }
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include <algorithm>
+
+#include <cb/critterbits.hpp>
+
+namespace Critterbits {
+namespace {
+bool RenderItemOrder(unsigned int lhs, unsigned int rhs) {
+    // untextured items (debug primitives, ordinal 0) always draw after textured ones in the same layer
+    if (lhs == 0 || rhs == 0) {
+        return lhs != 0 && rhs == 0;
+    }
+    return lhs < rhs;
+}
+}
+
+void RenderList::AddEntity(Entity & entity, Viewport & viewport) {
+    if (CollectEntity(entity, viewport, this->layers)) {
+        Engine::GetInstance().counters.RenderedEntity();
+    }
+}
+
+void RenderList::AddSpritesParallel(const std::vector<std::shared_ptr<Sprite>> & sprites, Viewport & viewport) {
+    // each chunk culls into its own lists, which are appended in chunk order so the result matches a serial build
+    size_t chunk_count = (sprites.size() + CB_JOBS_CULLING_GRAIN - 1) / CB_JOBS_CULLING_GRAIN;
+    if (this->cull_chunks.size() < chunk_count) {
+        this->cull_chunks.resize(chunk_count);
+    }
+    Engine::GetInstance().jobs.ParallelFor(chunk_count, 1, [this, &sprites, &viewport](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++) {
+            CullChunk & chunk = this->cull_chunks[c];
+            for (auto & layer : chunk.layers) {
+                layer.clear();
+            }
+            chunk.active_count = 0;
+            chunk.visible_count = 0;
+            size_t last = std::min((c + 1) * CB_JOBS_CULLING_GRAIN, sprites.size());
+            for (size_t i = c * CB_JOBS_CULLING_GRAIN; i < last; i++) {
+                if (sprites[i]->IsActive()) {
+                    chunk.active_count++;
+                    if (CollectEntity(*sprites[i], viewport, chunk.layers)) {
+                        chunk.visible_count++;
+                    }
+                }
+            }
+        }
+    });
+
+    EngineCounters & counters = Engine::GetInstance().counters;
+    for (size_t c = 0; c < chunk_count; c++) {
+        CullChunk & chunk = this->cull_chunks[c];
+        for (int i = 0; i < CB_WORLD_LAYER_COUNT; i++) {
+            this->layers[i].insert(this->layers[i].end(), chunk.layers[i].begin(), chunk.layers[i].end());
+        }
+        counters.CountedEntity(chunk.active_count);
+        counters.RenderedEntity(chunk.visible_count);
+    }
+}
+
+void RenderList::Build(Scene * scene, Viewport & viewport, bool include_map_regions) {
+    this->Clear();
+    if (scene == nullptr) {
+        return;
+    }
+
+    EngineCounters & counters = Engine::GetInstance().counters;
+    if (scene->HasTilemap()) {
+        Tilemap & tilemap = *scene->GetTilemap();
+        if (tilemap.IsActive()) {
+            counters.CountedEntity();
+            this->AddEntity(tilemap, viewport);
+        }
+
+        // map regions only ever draw debug overlays, so don't look at them unless those are on
+        counters.CountedEntity(tilemap.GetRegionEntityCount());
+        if (include_map_regions) {
+            std::vector<size_t> region_indexes;
+            tilemap.QueryCollisionRegions(viewport.dim, &region_indexes);
+            for (size_t region_index : region_indexes) {
+                const std::shared_ptr<TilemapRegion> & region = tilemap.GetRegions()[region_index];
+                if (region != nullptr && region->IsActive()) {
+                    this->AddEntity(*region, viewport);
+                }
+            }
+        }
+    }
+    if (Engine::GetInstance().config->threading.parallel_culling &&
+        scene->sprites.sprites.size() > CB_JOBS_CULLING_GRAIN) {
+        this->AddSpritesParallel(scene->sprites.sprites, viewport);
+    } else {
+        for (auto & sprite : scene->sprites.sprites) {
+            if (sprite->IsActive()) {
+                counters.CountedEntity();
+                this->AddEntity(*sprite, viewport);
+            }
+        }
+    }
+
+    for (auto & layer : this->layers) {
+        std::stable_sort(layer.begin(), layer.end(), [](const RenderItem & lhs, const RenderItem & rhs) {
+            return RenderItemOrder(lhs.texture_ordinal, rhs.texture_ordinal);
+        });
+    }
+}
+
+bool RenderList::CollectEntity(Entity & entity, const Viewport & viewport, std::vector<RenderItem> * layers) {
+    // only reads from the entity and viewport, so this is safe to call from worker threads
+    unsigned int render_layers = entity.GetRenderLayers();
+    if (render_layers == 0 || !entity.dim.intersects(viewport.dim)) {
+        return false;
+    }
+    unsigned int texture_ordinal = entity.GetRenderTexture() != nullptr ? entity.GetRenderTextureOrdinal() : 0;
+    for (int i = 0; i < CB_WORLD_LAYER_COUNT; i++) {
+        ZIndex z_index = static_cast<ZIndex>(i);
+        if (TestBitMask<unsigned int>(render_layers, ZIndexMask(z_index))) {
+            layers[i].push_back(RenderItem{&entity, texture_ordinal, viewport.GetViewableRect(entity.dim, z_index)});
+        }
+    }
+    return true;
+}
+
+void RenderList::Clear() {
+    for (auto & layer : this->layers) {
+        layer.clear();
+    }
+}
+
+size_t RenderList::GetItemCount() const {
+    size_t count = 0;
+    for (auto & layer : this->layers) {
+        count += layer.size();
+    }
+    return count;
+}
+
+void RenderList::Render(SDL_Renderer * renderer) const {
+    for (auto & layer : this->layers) {
+        for (auto & item : layer) {
+            if (!item.entity->RenderBatched(this->batch, item.clip)) {
+                // anything drawn immediately has to land on top of what's already been batched
+                this->batch.Flush(renderer);
+                item.entity->Render(renderer, item.clip);
+            }
+        }
+        this->batch.Flush(renderer);
+    }
+}
+}
\ No newline at end of file
@@ -6,15 +6,23 @@ Scene::~Scene() {}
 
 void Scene::NotifyLoaded() {
     LOG_INFO("Scene::NotifyLoaded scene was loaded: " + this->scene_name);
+
+    // sprites of a persistent scene survive while it is inactive, make them reachable again
+    EntityRegistry & entities = Engine::GetInstance().entities;
+    for (auto & sprite : this->sprites.sprites) {
+        entities.Register(sprite);
+    }
+
     EngineEventQueue::GetInstance().QueuePreUpdate((PreUpdateEvent)[this]() {
         // if this scene has a tilemap, make sure it's ready to render
         if (!this->map_path.empty()) {
             LOG_INFO("Scene::NotifyLoaded(pre-update) beginning tile map preparation for scene " + this->scene_name);
 
             this->tilemap = std::make_shared<Tilemap>(this->map_path);
-            if (!this->tilemap->CreateTextures(this->map_scale)) {
-                LOG_ERR("Scene::NotifyLoaded(pre-update) unable to generate textures for tilemap " + this->map_path);
+            if (!this->tilemap->LoadMap(this->map_scale)) {
+                LOG_ERR("Scene::NotifyLoaded(pre-update) unable to load tilemap " + this->map_path);
             }
+            Engine::GetInstance().entities.Register(this->tilemap);
         }
 
         // if this scene has a scene-wide script, load it and attach to a special sprite
@@ -26,7 +34,8 @@ void Scene::NotifyLoaded() {
                 scene_sprite->sprite_name = ":" + this->scene_name;
                 scene_sprite->script = std::move(script);
                 scene_sprite->state = EntityState::Active;
-                this->sprites.sprites.push_back(std::move(scene_sprite));
+                Engine::GetInstance().entities.Register(scene_sprite);
+                this->sprites.AddSprite(std::move(scene_sprite));
             }
         }
 
@@ -36,6 +45,33 @@ void Scene::NotifyLoaded() {
 
 void Scene::NotifyUnloaded(bool unloading) {
     LOG_INFO("Scene::NotifyUnloaded scene was unloaded: " + this->scene_name);
+
+    // entities of an inactive scene should no longer be found by ID, and once the scene is gone for good their
+    // script proxies can go too. The tilemap and its regions are rebuilt with new IDs every time the scene is loaded,
+    // so their proxies always go.
+    EntityRegistry & entities = Engine::GetInstance().entities;
+    Scripting::ScriptEngine & scripts = Engine::GetInstance().scripts;
+    auto unregister = [&entities, &scripts, unloading](entity_id_t entity_id) {
+        entities.Unregister(entity_id);
+        if (unloading) {
+            scripts.ReleaseEntity(entity_id);
+        }
+    };
+    if (this->tilemap != nullptr) {
+        // baked chunks are cheap to bake again if the scene comes back
+        this->tilemap->ReleaseChunks();
+        entities.Unregister(this->tilemap->entity_id);
+        scripts.ReleaseEntity(this->tilemap->entity_id);
+        for (auto & region : this->tilemap->GetRegions()) {
+            if (region != nullptr) {
+                entities.Unregister(region->entity_id);
+                scripts.ReleaseEntity(region->entity_id);
+            }
+        }
+    }
+    for (auto & sprite : this->sprites.sprites) {
+        unregister(sprite->entity_id);
+    }
     this->state = unloading ? SceneState::Unloaded : SceneState::Inactive;
 }
 }
\ No newline at end of file
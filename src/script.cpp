@@ -8,7 +8,84 @@ namespace Scripting {
 
 entity_id_t next_callback_id = CB_ENTITY_ID_FIRST;
 
+namespace {
+void ArmCallback(Entity & owner, std::shared_ptr<CB_ScriptCallback> callback) {
+    TimerWheel & timers = Engine::GetInstance().timers;
+    if (!owner.IsActive() || owner.time_scale == 0.f) {
+        // owner is paused, hold the callback off the wheel until RescheduleCallbacks picks it back up
+        timers.Cancel(callback->callback_id);
+        callback->scale = 0.f;
+        owner.callbacks_paused = true;
+        return;
+    }
+    // timers run on engine time, stretch or shrink the delay by the owner's time scale like its updates are
+    callback->scale = owner.time_scale > 0.f ? owner.time_scale : 1.f;
+    callback->armed_at = timers.GetTime();
+    unsigned int delay_ms =
+        callback->remaining > 0.f ? static_cast<unsigned int>(callback->remaining / callback->scale) : 0;
+    timers.Schedule(callback->callback_id, delay_ms, [callback]() {
+        std::shared_ptr<Entity> owner = callback->owner.lock();
+        if (owner == nullptr || !owner->HasScript()) {
+            // callback's owner no longer exists, dump it
+            return;
+        }
+        if (!owner->IsActive() || owner->time_scale == 0.f) {
+            // owner stopped without a reschedule, the callback is due as soon as it runs again
+            callback->remaining = 0.f;
+            ArmCallback(*owner, callback);
+            return;
+        }
+        owner->script->FireCallback(owner, callback);
+    });
+}
+
+void RemoveCallback(Entity & owner, entity_id_t callback_id) {
+    for (auto it = owner.callbacks.begin(); it != owner.callbacks.end(); ++it) {
+        if ((*it)->callback_id == callback_id) {
+            owner.callbacks.erase(it);
+            return;
+        }
+    }
+}
+}
+
+void Script::CallBatchedCollisions() {
+    if (this->batched_collisions.empty()) {
+        return;
+    }
+    if (this->global_oncollision_all) {
+        this->CallOnCollisionAll();
+    } else {
+        // oncollision_all failed earlier in the frame, fall back to one call per collision
+        for (auto & collision : this->batched_collisions) {
+            this->CallOnCollision(collision.first, collision.second);
+        }
+    }
+    this->batched_collisions.clear();
+}
+
+void Script::CallBatchedUpdates() {
+    for (auto & batch : this->batched_updates) {
+        if (batch.entities.empty()) {
+            continue;
+        }
+        if (this->global_update_all) {
+            this->CallUpdateAll(batch.entities, batch.delta_time);
+        } else {
+            // update_all failed earlier in the frame, fall back to one call per entity
+            for (auto & entity : batch.entities) {
+                if (entity->IsActive()) {
+                    this->CallUpdate(entity, batch.delta_time);
+                }
+            }
+        }
+        // keep the batch (and its capacity) around for the next frame
+        batch.entities.clear();
+    }
+}
+
 bool Script::CallCallback(std::shared_ptr<Entity> entity, const CB_ScriptCallback & callback) {
+    ScriptProfileScope profile_scope{*this, ScriptEntryPoint::Callback};
     CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(this->context);
     bool retval = false;
     duk_push_global_stash(this->context);
@@ -63,6 +140,10 @@ void Script::DiscoverGlobals() {
                     this->global_start = true;
                 } else if (strcmp(prop_name, CB_SCRIPT_GLOBAL_ONCOLLISION) == 0) {
                     this->global_oncollision = true;
+                } else if (strcmp(prop_name, CB_SCRIPT_GLOBAL_UPDATE_ALL) == 0) {
+                    this->global_update_all = true;
+                } else if (strcmp(prop_name, CB_SCRIPT_GLOBAL_ONCOLLISION_ALL) == 0) {
+                    this->global_oncollision_all = true;
                 }
             } else {
                 LOG_ERR("Script::DiscoverGlobals error retrieving property at index " + std::to_string(i));
@@ -75,6 +156,8 @@ void Script::DiscoverGlobals() {
 }
 
 void Script::CallOnCollision(std::shared_ptr<Entity> entity, std::shared_ptr<Entity> other_entity) {
+    CB_PROFILE_SPAN(ProfileSpan::Scripts, this->script_path);
+    ScriptProfileScope profile_scope{*this, ScriptEntryPoint::OnCollision};
     CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(this->context);
     if (this->global_oncollision) {
         // setup call to global oncollision script
@@ -85,7 +168,7 @@ void Script::CallOnCollision(std::shared_ptr<Entity> entity, std::shared_ptr<Ent
         if (duk_pcall_method(this->context, 1) == DUK_EXEC_SUCCESS) {
             // clean up and pull any changes to the entities
             duk_pop_2(this->context);
-            this->PostCallRetrieveAllEntities();
+            this->PostCallApplyEntityChanges();
         } else {
             LOG_ERR("Script::CallOnCollision oncollision() call failed in " + this->script_path + " - " +
                     std::string(duk_safe_to_string(this->context, -1)));
@@ -97,7 +180,41 @@ void Script::CallOnCollision(std::shared_ptr<Entity> entity, std::shared_ptr<Ent
     CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
 }
 
+void Script::CallOnCollisionAll() {
+    CB_PROFILE_SPAN(ProfileSpan::Scripts, this->script_path);
+    ScriptProfileScope profile_scope{*this, ScriptEntryPoint::OnCollisionAll};
+    CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(this->context);
+    // setup call to global oncollision_all script, with the module as this and every collision in one array
+    duk_get_global_string(this->context, this->script_name.c_str());
+    duk_get_prop_string(this->context, -1, CB_SCRIPT_GLOBAL_ONCOLLISION_ALL);
+    duk_dup(this->context, -2);
+    duk_idx_t arr_idx = duk_push_array(this->context);
+    duk_uarridx_t prop_idx = 0;
+    for (auto & collision : this->batched_collisions) {
+        duk_push_object(this->context);
+        CreateEntityInContext(this->context, collision.first);
+        duk_put_prop_string(this->context, -2, "entity");
+        CreateEntityInContext(this->context, collision.second);
+        duk_put_prop_string(this->context, -2, "other");
+        duk_put_prop_index(this->context, arr_idx, prop_idx++);
+    }
+    if (duk_pcall_method(this->context, 1) == DUK_EXEC_SUCCESS) {
+        // clean up and pull any changes to the entities
+        duk_pop_2(this->context);
+        this->PostCallApplyEntityChanges();
+    } else {
+        LOG_ERR("Script::CallOnCollisionAll oncollision_all() call failed in " + this->script_path + " - " +
+                std::string(duk_safe_to_string(this->context, -1)));
+        duk_pop_2(this->context);
+        // turn off the oncollision_all script so we don't get caught in an infinite loop of errors
+        this->global_oncollision_all = false;
+    }
+    CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
+}
+
 void Script::CallStart(std::shared_ptr<Entity> entity) {
+    CB_PROFILE_SPAN(ProfileSpan::Scripts, this->script_path);
+    ScriptProfileScope profile_scope{*this, ScriptEntryPoint::Start};
     CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(this->context);
     if (this->global_start) {
         // setup call to global start script
@@ -107,7 +224,7 @@ void Script::CallStart(std::shared_ptr<Entity> entity) {
         if (duk_pcall_method(this->context, 0) == DUK_EXEC_SUCCESS) {
             // clean up and pull any changes to the entity
             duk_pop_2(this->context);
-            this->PostCallRetrieveAllEntities();
+            this->PostCallApplyEntityChanges();
         } else {
             LOG_ERR("Script::CallStart start() call failed in " + this->script_path + " - " +
                     std::string(duk_safe_to_string(this->context, -1)));
@@ -120,6 +237,8 @@ void Script::CallStart(std::shared_ptr<Entity> entity) {
 }
 
 void Script::CallUpdate(std::shared_ptr<Entity> entity, float delta_time) {
+    CB_PROFILE_SPAN(ProfileSpan::Scripts, this->script_path);
+    ScriptProfileScope profile_scope{*this, ScriptEntryPoint::Update};
     CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(this->context);
     if (this->global_update) {
         // setup call to global update script
@@ -131,34 +250,8 @@ void Script::CallUpdate(std::shared_ptr<Entity> entity, float delta_time) {
             // clean up
             duk_pop_2(this->context);
 
-            // check callbacks
-            for (auto it = this->callbacks.begin(); it != this->callbacks.end();) {
-                CB_ScriptCallback * callback = it->get();
-                if (auto callback_owner = callback->owner.lock()) {
-                    if (callback_owner->entity_id == entity->entity_id) {
-                        // update time elapsed and check if we've passed interval
-                        callback->accrued += delta_time * 1000;
-                        if (callback->accrued >= callback->delay) {
-                            if (this->CallCallback(entity, *callback)) {
-                                // callback continuing, reset timer
-                                callback->accrued = 0;
-                            } else {
-                                // callback isn't interested in continuing
-                                it = this->callbacks.erase(it);
-                                continue;
-                            }
-                        }
-                    }
-                } else {
-                    // callbacks's owner no longer exists, dump it
-                    it = this->callbacks.erase(it);
-                    continue;
-                }
-                it++;
-            }
-
             // pull any changes to entities
-            this->PostCallRetrieveAllEntities();
+            this->PostCallApplyEntityChanges();
         } else {
             LOG_ERR("Script::CallUpdate update() call failed in " + this->script_path + " - " +
                     std::string(duk_safe_to_string(this->context, -1)));
@@ -170,36 +263,110 @@ void Script::CallUpdate(std::shared_ptr<Entity> entity, float delta_time) {
     CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
 }
 
-void Script::PostCallRetrieveAllEntities() {
-    CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
-    // iterate all entities in the global stash
-    duk_push_global_stash(this->context);
-    if (duk_get_prop_string(this->context, -1, CB_SCRIPT_ENTITY_STASH_ARRAY)) {
-        int num_ents = duk_get_length(context, -1);
-        for (int i = 0; i < num_ents; i++) {
-            if (duk_get_prop_index(context, -1, i) != 0) {
-                if (duk_is_object(context, -1)) {
-                    duk_get_prop_string(context, -1, CB_SCRIPT_HIDDEN_ENTITYID);
-                    entity_id_t eid = duk_get_int(context, -1);
-                    duk_pop(context);
-                    std::shared_ptr<Entity> entity = Engine::GetInstance().FindEntityById(eid);
-                    if (entity != nullptr) {
-                        RetrieveEntityFromContextAt(this->context, entity);
-                    }
-                }
-            } else {
-                LOG_ERR("CreateEntityInContext error retrieving property at index " + std::to_string(i));
-            }
-            duk_pop(context);
+void Script::CallUpdateAll(const std::vector<std::shared_ptr<Entity>> & entities, float delta_time) {
+    CB_PROFILE_SPAN(ProfileSpan::Scripts, this->script_path);
+    ScriptProfileScope profile_scope{*this, ScriptEntryPoint::UpdateAll};
+    CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(this->context);
+    // setup call to global update_all script, with the module as this and every entity in one array
+    duk_get_global_string(this->context, this->script_name.c_str());
+    duk_get_prop_string(this->context, -1, CB_SCRIPT_GLOBAL_UPDATE_ALL);
+    duk_dup(this->context, -2);
+    duk_idx_t arr_idx = duk_push_array(this->context);
+    duk_uarridx_t prop_idx = 0;
+    for (auto & entity : entities) {
+        // an earlier update this frame may have destroyed the entity
+        if (entity->IsActive()) {
+            CreateEntityInContext(this->context, entity);
+            duk_put_prop_index(this->context, arr_idx, prop_idx++);
+        }
+    }
+    if (prop_idx == 0) {
+        // every queued entity went inactive earlier in the frame, so there is nothing to pass to update_all
+        duk_pop_n(this->context, 4);
+    } else {
+        duk_push_number(this->context, delta_time);
+        if (duk_pcall_method(this->context, 2) == DUK_EXEC_SUCCESS) {
+            // clean up and pull any changes to the entities
+            duk_pop_2(this->context);
+            this->PostCallApplyEntityChanges();
+        } else {
+            LOG_ERR("Script::CallUpdateAll update_all() call failed in " + this->script_path + " - " +
+                    std::string(duk_safe_to_string(this->context, -1)));
+            duk_pop_2(this->context);
+            // turn off the update_all script so we don't get caught in an infinite loop of errors
+            this->global_update_all = false;
         }
     }
-    duk_pop_2(this->context); // stash and array
-    ClearEntitiesInContext(this->context);
     CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
 }
 
+void Script::CancelCallback(Entity & owner, entity_id_t callback_id) {
+    Engine::GetInstance().timers.Cancel(callback_id);
+    RemoveCallback(owner, callback_id);
+}
+
+void Script::FireCallback(std::shared_ptr<Entity> entity, std::shared_ptr<CB_ScriptCallback> callback) {
+    CB_PROFILE_SPAN(ProfileSpan::Scripts, this->script_path);
+    if (this->CallCallback(entity, *callback)) {
+        // callback continuing, wait for the next interval
+        callback->remaining = static_cast<float>(callback->delay);
+        ArmCallback(*entity, callback);
+    } else {
+        // the callback may have been re-armed while it ran (i.e. it changed its owner's time_scale)
+        this->CancelCallback(*entity, callback->callback_id);
+    }
+    this->PostCallApplyEntityChanges();
+}
+
+void Script::PostCallApplyEntityChanges() {
+    // proxies write straight through to their entities, only deferred changes (i.e. position) are left to apply
+    ApplyPendingEntityChanges();
+}
+
 void Script::QueueCallback(std::unique_ptr<CB_ScriptCallback> callback) {
-    this->callbacks.push_back(std::move(callback));
+    std::shared_ptr<Entity> owner = callback->owner.lock();
+    if (owner != nullptr) {
+        std::shared_ptr<CB_ScriptCallback> pending{std::move(callback)};
+        pending->remaining = static_cast<float>(pending->delay);
+        owner->callbacks.push_back(pending);
+        ArmCallback(*owner, pending);
+    }
+}
+
+void Script::QueueCollision(std::shared_ptr<Entity> entity, std::shared_ptr<Entity> other_entity) {
+    this->batched_collisions.emplace_back(std::move(entity), std::move(other_entity));
+}
+
+void Script::QueueUpdate(std::shared_ptr<Entity> entity, float delta_time) {
+    // entities are batched by their scaled delta time, which is the same for all of them unless time_scale is in use
+    BatchedUpdate * available = nullptr;
+    for (auto & batch : this->batched_updates) {
+        if (batch.delta_time == delta_time) {
+            batch.entities.push_back(std::move(entity));
+            return;
+        } else if (available == nullptr && batch.entities.empty()) {
+            available = &batch;
+        }
+    }
+    if (available == nullptr) {
+        this->batched_updates.emplace_back();
+        available = &this->batched_updates.back();
+    }
+    available->delta_time = delta_time;
+    available->entities.push_back(std::move(entity));
+}
+
+void Script::RescheduleCallbacks(Entity & owner) {
+    // the wheel only counts engine time, so take off the entity time each armed callback has used at the scale it was
+    // armed with, then arm it again at the owner's current scale (or park it if the owner is paused)
+    unsigned long long now = Engine::GetInstance().timers.GetTime();
+    owner.callbacks_paused = false;
+    for (auto & callback : owner.callbacks) {
+        if (callback->scale > 0.f) {
+            callback->remaining -= static_cast<float>(now - callback->armed_at) * callback->scale;
+        }
+        ArmCallback(owner, callback);
+    }
 }
 }
 }
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include <cb/critterbits.hpp>
 #include <cb/scripting/scriptsupport.hpp>
 
@@ -13,10 +15,36 @@ void duktape_fatal_error(duk_context * ctx, duk_errcode_t code, const char * msg
     abort();
 }
 
+/*
+ * Heap memory hooks for duktape, udata is the script engine's PoolAllocator
+ */
+void * duktape_alloc(void * udata, duk_size_t size) { return static_cast<PoolAllocator *>(udata)->Allocate(size); }
+
+void duktape_free(void * udata, void * ptr) { static_cast<PoolAllocator *>(udata)->Free(ptr); }
+
+void * duktape_realloc(void * udata, void * ptr, duk_size_t size) {
+    return static_cast<PoolAllocator *>(udata)->Reallocate(ptr, size);
+}
+
+#ifdef DUK_USE_BYTECODE_DUMP_SUPPORT
+/*
+ * Loads and runs precompiled global code from the buffer on top of the stack. Duktape does not validate bytecode,
+ * and loading a malformed buffer is memory-unsafe rather than an error, so pack bytecode is trusted input: the pack
+ * loader only hands over entries whose checksum matches, which catches damage but not tampering. duk_safe_call only
+ * catches errors that are thrown, such as an exception while running the script's global code.
+ */
+duk_ret_t run_bytecode(duk_context * context) {
+    duk_load_function(context);
+    duk_call(context, 0);
+    return 1;
+}
+#endif
+
 /*
 * Functions callable from JavaScript code
 */
 duk_ret_t close_gui_panel(duk_context * context) {
+    CB_SCRIPT_SAMPLE_POINT(context);
     CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
     entity_id_t to_close = duk_get_uint(context, 0);
     bool closed = Engine::GetInstance().gui.ClosePanel(to_close);
@@ -26,15 +54,16 @@ duk_ret_t close_gui_panel(duk_context * context) {
 }
 
 duk_ret_t find_entities_by_tag(duk_context * context) {
+    CB_SCRIPT_SAMPLE_POINT(context);
     CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
     int nargs = duk_get_top(context);
-    std::vector<std::string> tags;
-    for (int i = 0; i < nargs; i++) {
-        tags.push_back(std::string(duk_get_string(context, i)));
-    }
     int arr_idx = duk_push_array(context);
     int prop_idx = 0;
-    for (auto & tag : tags) {
+    for (int i = 0; i < nargs; i++) {
+        const char * tag = duk_get_string(context, i);
+        if (tag == nullptr) {
+            continue;
+        }
         for (auto & entity : Engine::GetInstance().FindEntitiesByTag(tag)) {
             CreateEntityInContext(context, entity);
             duk_put_prop_index(context, arr_idx, prop_idx++);
@@ -45,6 +74,7 @@ duk_ret_t find_entities_by_tag(duk_context * context) {
 }
 
 duk_ret_t is_direction_pressed(duk_context * context) {
+    CB_SCRIPT_SAMPLE_POINT(context);
     CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
     int direction = duk_get_int(context, 0);
     bool axis_pressed = Engine::GetInstance().input.IsAxisPressed(static_cast<InputDirection>(direction));
@@ -54,6 +84,7 @@ duk_ret_t is_direction_pressed(duk_context * context) {
 }
 
 duk_ret_t is_controller_direction_pressed(duk_context * context) {
+    CB_SCRIPT_SAMPLE_POINT(context);
     CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
     int direction = duk_get_int(context, 0);
     bool axis_pressed = Engine::GetInstance().input.IsControllerAxisPressed(static_cast<InputDirection>(direction));
@@ -63,6 +94,7 @@ duk_ret_t is_controller_direction_pressed(duk_context * context) {
 }
 
 duk_ret_t is_key_pressed(duk_context * context) {
+    CB_SCRIPT_SAMPLE_POINT(context);
     CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
     int key_code = duk_get_int(context, 0);
     bool key_pressed = Engine::GetInstance().input.IsKeyPressed(static_cast<CB_KeyCode>(key_code));
@@ -72,6 +104,7 @@ duk_ret_t is_key_pressed(duk_context * context) {
 }
 
 duk_ret_t is_key_pressed_once(duk_context * context) {
+    CB_SCRIPT_SAMPLE_POINT(context);
     CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
     int key_code = duk_get_int(context, 0);
     bool key_pressed = Engine::GetInstance().input.IsKeyPressedOnce(static_cast<CB_KeyCode>(key_code));
@@ -81,6 +114,7 @@ duk_ret_t is_key_pressed_once(duk_context * context) {
 }
 
 duk_ret_t lerp(duk_context * context) {
+    CB_SCRIPT_SAMPLE_POINT(context);
     CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
     CB_Point start, end;
     float scalar{0.0f};
@@ -104,6 +138,7 @@ duk_ret_t lerp(duk_context * context) {
 }
 
 duk_ret_t quad_ease_in(duk_context * context) {
+    CB_SCRIPT_SAMPLE_POINT(context);
     CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
     CB_Point start, end;
     float scalar{0.0f};
@@ -127,6 +162,7 @@ duk_ret_t quad_ease_in(duk_context * context) {
 }
 
 duk_ret_t open_gui_panel(duk_context * context) {
+    CB_SCRIPT_SAMPLE_POINT(context);
     CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
     entity_id_t opened = CB_ENTITY_ID_INVALID;
     if (duk_is_string(context, 0)) {
@@ -148,6 +184,7 @@ duk_ret_t open_gui_panel(duk_context * context) {
 }
 
 duk_ret_t spawn_sprite(duk_context * context) {
+    CB_SCRIPT_SAMPLE_POINT(context);
     CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
     if (duk_is_string(context, 0)) {
         QueuedSprite qsprite;
@@ -164,7 +201,33 @@ duk_ret_t spawn_sprite(duk_context * context) {
     return 0;
 }
 
+duk_ret_t spawn_sprites(duk_context * context) {
+    CB_SCRIPT_SAMPLE_POINT(context);
+    CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
+    if (duk_is_string(context, 0) && duk_is_array(context, 1) && Engine::GetInstance().scenes.IsCurrentSceneActive()) {
+        SpriteManager & sprites = Engine::GetInstance().scenes.current_scene->sprites;
+        QueuedSprite qsprite;
+        qsprite.name = duk_get_string(context, 0);
+        duk_size_t count = duk_get_length(context, 1);
+        for (duk_size_t i = 0; i < count; i++) {
+            duk_get_prop_index(context, 1, i);
+            if (duk_is_object(context, -1)) {
+                qsprite.at.x = GetPropertyInt(context, "x", -1);
+                qsprite.at.y = GetPropertyInt(context, "y", -1);
+            } else {
+                qsprite.at.x = 0;
+                qsprite.at.y = 0;
+            }
+            duk_pop(context);
+            sprites.QueueSprite(qsprite);
+        }
+    }
+    CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
+    return 0;
+}
+
 duk_ret_t viewport_follow(duk_context * context) {
+    CB_SCRIPT_SAMPLE_POINT(context);
     CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
     bool success = false;
     if (duk_is_object(context, 0)) {
@@ -189,7 +252,8 @@ duk_ret_t viewport_follow(duk_context * context) {
 }
 
 ScriptEngine::ScriptEngine() {
-    this->context = duk_create_heap(NULL, NULL, NULL, NULL, duktape_fatal_error);
+    this->context =
+        duk_create_heap(duktape_alloc, duktape_realloc, duktape_free, &this->allocator, duktape_fatal_error);
     if (this->context == nullptr) {
         LOG_ERR("ScriptEngine::ScriptEngine unable to create duktape context");
     }
@@ -201,6 +265,18 @@ ScriptEngine::~ScriptEngine() {
     }
 }
 
+void ScriptEngine::CallBatchedCollisions() {
+    for (auto & script : this->loaded_scripts) {
+        script->CallBatchedCollisions();
+    }
+}
+
+void ScriptEngine::CallBatchedUpdates() {
+    for (auto & script : this->loaded_scripts) {
+        script->CallBatchedUpdates();
+    }
+}
+
 #define CB_PUT_KEYCODE(k)                                                                                              \
     duk_push_int(context, SDLK_##k);                                                                                   \
     duk_put_prop_string(context, -2, #k);
@@ -245,6 +321,7 @@ void ScriptEngine::AddCommonScriptingFunctions(duk_context * context) const {
     PushPropertyFunction(context, "open_gui", open_gui_panel, 2);
     PushPropertyFunction(context, "ease_in", quad_ease_in, 3);
     PushPropertyFunction(context, "spawn", spawn_sprite, 2);
+    PushPropertyFunction(context, "spawn_many", spawn_sprites, 2);
 
     duk_pop(context); // global
     CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
@@ -284,18 +361,42 @@ std::shared_ptr<Script> ScriptEngine::LoadScript(const std::string & script_path
     // TODO: eliminate old script-specific contexts
     new_script->context = this->context;
 
-    // load associated script file
-    std::string * script_contents = nullptr;
-    if (Engine::GetInstance().GetResourceLoader()->GetTextResourceContents(script_path, &script_contents) == false) {
-        LOG_ERR("ScriptEngine::LoadScript unable to get script " + script_path);
-        return nullptr;
+    // use the precompiled bytecode if the pack has some for this version of duktape, otherwise compile the source
+    bool loaded = false;
+#ifdef DUK_USE_BYTECODE_DUMP_SUPPORT
+    std::string * script_bytecode = nullptr;
+    if (Engine::GetInstance().GetResourceLoader()->GetScriptBytecode(script_path, DUK_VERSION, &script_bytecode)) {
+        void * buffer = duk_push_fixed_buffer(new_script->context, script_bytecode->length());
+        std::memcpy(buffer, script_bytecode->data(), script_bytecode->length());
+        delete script_bytecode;
+        if (duk_safe_call(new_script->context, run_bytecode, 1, 1) == DUK_EXEC_SUCCESS) {
+            LOG_INFO("ScriptEngine::LoadScript loaded bytecode for " + script_path);
+            loaded = true;
+        } else {
+            const char * error = duk_safe_to_string(new_script->context, -1);
+            LOG_ERR("ScriptEngine::LoadScript unable to load bytecode for " + script_path + ", error was " +
+                    std::string(error) + "; falling back to source");
+        }
+        duk_pop(new_script->context);
     }
-    if (duk_peval_string_noresult(new_script->context, (*script_contents).c_str()) != 0) {
-        const char * error = duk_safe_to_string(new_script->context, -1);
-        LOG_ERR("ScriptEngine::LoadScript unable to compile script " + script_path + ", error was " + std::string(error));
-        return nullptr;
+#endif
+
+    // load associated script file
+    if (!loaded) {
+        std::string * script_contents = nullptr;
+        if (Engine::GetInstance().GetResourceLoader()->GetTextResourceContents(script_path, &script_contents) ==
+            false) {
+            LOG_ERR("ScriptEngine::LoadScript unable to get script " + script_path);
+            return nullptr;
+        }
+        if (duk_peval_string_noresult(new_script->context, (*script_contents).c_str()) != 0) {
+            const char * error = duk_safe_to_string(new_script->context, -1);
+            LOG_ERR("ScriptEngine::LoadScript unable to compile script " + script_path + ", error was " +
+                    std::string(error));
+            return nullptr;
+        }
+        delete script_contents;
     }
-    delete script_contents;
 
     // prepare the script object
     new_script->DiscoverGlobals();
@@ -304,6 +405,12 @@ std::shared_ptr<Script> ScriptEngine::LoadScript(const std::string & script_path
     return new_script;
 }
 
+void ScriptEngine::ReleaseEntity(entity_id_t entity_id) {
+    if (this->context != nullptr) {
+        ReleaseEntityInContext(this->context, entity_id);
+    }
+}
+
 void ScriptEngine::StartEngine() {
     this->AddCommonScriptingFunctions(this->context);
 }
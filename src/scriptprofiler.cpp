@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#include <cb/critterbits.hpp>
+#include <cb/scripting/scriptsupport.hpp>
+
+/*
+ * Exec timeout hook for the engine's duktape build (see 3pp/duktape/duktape_interrupt.c). Called every so many
+ * bytecode instructions, it only flags a sample for the script profiler and never interrupts the script.
+ */
+namespace {
+// only set while sampling; the hook also runs while duk_create_heap sets up the heap, which happens while the engine
+// itself is still being constructed, so it can't go through Engine::GetInstance()
+Critterbits::Scripting::ScriptProfiler * sampling_profiler = nullptr;
+}
+
+extern "C" int critterbits_duktape_interrupt(void * udata) {
+    if (sampling_profiler != nullptr) {
+        sampling_profiler->Interrupt();
+    }
+    return 0;
+}
+
+namespace Critterbits {
+namespace Scripting {
+
+namespace {
+const char * entry_point_names[CB_SCRIPT_ENTRY_POINT_COUNT] = {"start",       "update",          "update_all",
+                                                               "oncollision", "oncollision_all", "callback"};
+
+void AppendFrameName(std::string & key, const char * name) {
+    // keep the folded format intact, frames are separated by ';' and the count follows a space
+    key += ';';
+    if (name == nullptr || *name == '\0') {
+        key += "(anonymous)";
+        return;
+    }
+    for (const char * c = name; *c != '\0'; c++) {
+        key += (*c == ';' || *c == ' ' || *c == '\n') ? '_' : *c;
+    }
+}
+}
+
+Uint64 ScriptProfiler::BeginCall(const std::string & script_name, ScriptEntryPoint entry_point) {
+    auto script = this->scripts.find(script_name);
+    if (script == this->scripts.end()) {
+        script = this->scripts.emplace(script_name, ScriptStats{}).first;
+    }
+    this->call_stack.push_back(
+        ActiveCall{&script->first, entry_point, &script->second.entry_points[static_cast<int>(entry_point)]});
+    return SDL_GetPerformanceCounter();
+}
+
+void ScriptProfiler::CaptureSample(duk_context * context) {
+    // take the pending samples up front, reading the stack calls back into duktape and may trip the interrupt again
+    unsigned long sample_count = this->pending_samples;
+    this->pending_samples = 0;
+    if (this->call_stack.empty()) {
+        return;
+    }
+
+    CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
+    std::vector<std::string> frames;
+    duk_get_global_string(context, "Duktape");
+    duk_get_prop_string(context, -1, "act");
+    if (duk_is_function(context, -1)) {
+        // -1 is act() itself and -2 the native function that hit the sample point, the script's frames follow
+        for (int level = -3; frames.size() < CB_SCRIPT_PROFILER_MAX_DEPTH; level--) {
+            duk_dup(context, -1);
+            duk_push_int(context, level);
+            if (duk_pcall(context, 1) != DUK_EXEC_SUCCESS || !duk_is_object(context, -1)) {
+                duk_pop(context);
+                break;
+            }
+            duk_get_prop_string(context, -1, "function");
+            duk_get_prop_string(context, -1, "name");
+            const char * name = duk_get_string(context, -1);
+            frames.emplace_back(name != nullptr ? name : "");
+            duk_pop_3(context);
+        }
+    }
+    duk_pop_2(context);
+    CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
+
+    // the outermost frame is the function the engine called, which the entry point already names
+    std::string key = this->GetCallStackKey();
+    for (size_t i = frames.size(); i-- > 1;) {
+        AppendFrameName(key, frames[i].c_str());
+    }
+    this->samples[key] += sample_count;
+}
+
+void ScriptProfiler::EndCall(Uint64 start) {
+    if (this->call_stack.empty()) {
+        return;
+    }
+    // samples that never reached a sample point are counted against the entry point
+    if (this->pending_samples > 0) {
+        this->samples[this->GetCallStackKey()] += this->pending_samples;
+        this->pending_samples = 0;
+    }
+
+    Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+    EntryStats & stats = *this->call_stack.back().stats;
+    stats.calls++;
+    stats.total += elapsed;
+    stats.frame_calls++;
+    stats.frame_total += elapsed;
+    this->call_stack.pop_back();
+}
+
+std::string ScriptProfiler::GetCallStackKey() const {
+    std::string key;
+    for (auto & call : this->call_stack) {
+        if (!key.empty()) {
+            key += ';';
+        }
+        key += *call.script_name;
+        AppendFrameName(key, GetEntryPointName(call.entry_point));
+    }
+    return key;
+}
+
+const char * ScriptProfiler::GetEntryPointName(ScriptEntryPoint entry_point) {
+    return entry_point_names[static_cast<int>(entry_point)];
+}
+
+void ScriptProfiler::NewFrame() {
+    if (!this->enabled) {
+        return;
+    }
+    for (auto & script : this->scripts) {
+        for (auto & stats : script.second.entry_points) {
+            stats.last_frame_calls = stats.frame_calls;
+            stats.last_frame_total = stats.frame_total;
+            stats.frame_calls = 0;
+            stats.frame_total = 0;
+        }
+    }
+}
+
+void ScriptProfiler::SetEnabled(bool enabled, bool sampling) {
+    this->enabled = enabled;
+    this->sampling = enabled && sampling;
+    this->frequency = SDL_GetPerformanceFrequency();
+    sampling_profiler = this->sampling ? this : nullptr;
+}
+
+bool ScriptProfiler::WriteFoldedStacks(const std::string & path) const {
+    std::ofstream folded{path, std::ios::out | std::ios::trunc};
+    if (!folded.is_open()) {
+        LOG_ERR("ScriptProfiler::WriteFoldedStacks unable to open " + path);
+        return false;
+    }
+
+    // sample counts when sampling, otherwise the total time in microseconds per script and entry point
+    size_t written = 0;
+    if (this->sampling) {
+        for (auto & sample : this->samples) {
+            folded << sample.first << " " << sample.second << "\n";
+            written++;
+        }
+    } else {
+        for (auto & script : this->scripts) {
+            for (int i = 0; i < CB_SCRIPT_ENTRY_POINT_COUNT; i++) {
+                const EntryStats & stats = script.second.entry_points[i];
+                if (stats.calls > 0) {
+                    folded << script.first << ";" << entry_point_names[i] << " "
+                           << stats.total * 1000000 / this->frequency << "\n";
+                    written++;
+                }
+            }
+        }
+    }
+
+    LOG_INFO("ScriptProfiler::WriteFoldedStacks wrote " + std::to_string(written) + " stacks to " + path);
+    return true;
+}
+
+void ScriptProfiler::WriteFrameSummary(std::ostream & os, size_t count) const {
+    // busiest script entry points in the previous frame
+    std::vector<std::pair<std::string, const EntryStats *>> busiest;
+    for (auto & script : this->scripts) {
+        for (int i = 0; i < CB_SCRIPT_ENTRY_POINT_COUNT; i++) {
+            const EntryStats & stats = script.second.entry_points[i];
+            if (stats.last_frame_calls > 0) {
+                busiest.emplace_back(script.first + "." + entry_point_names[i], &stats);
+            }
+        }
+    }
+    count = std::min(count, busiest.size());
+    std::partial_sort(busiest.begin(), busiest.begin() + count, busiest.end(),
+                      [](const std::pair<std::string, const EntryStats *> & lhs,
+                         const std::pair<std::string, const EntryStats *> & rhs) {
+                          return lhs.second->last_frame_total > rhs.second->last_frame_total;
+                      });
+
+    os << std::fixed << std::setprecision(2) << "js ms";
+    for (size_t i = 0; i < count; i++) {
+        os << " | " << busiest[i].first << " " << busiest[i].second->last_frame_total * 1000.0 / this->frequency
+           << " x" << busiest[i].second->last_frame_calls;
+    }
+}
+
+ScriptProfileScope::ScriptProfileScope(const Script & script, ScriptEntryPoint entry_point) {
+    ScriptProfiler & profiler = Engine::GetInstance().scripts.GetProfiler();
+    if (profiler.IsEnabled()) {
+        this->active = true;
+        this->start = profiler.BeginCall(script.script_name, entry_point);
+    }
+}
+
+ScriptProfileScope::~ScriptProfileScope() {
+    if (this->active) {
+        Engine::GetInstance().scripts.GetProfiler().EndCall(this->start);
+    }
+}
+}
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include <cstdlib>
 #include <cstring>
+#include <unordered_map>
+#include <vector>
 
 #include <cb/critterbits.hpp>
 #include <cb/scripting/scriptsupport.hpp>
@@ -8,6 +10,94 @@ namespace Critterbits {
 namespace Scripting {
 
 namespace {
+/*
+ * Properties exposed to scripts through native accessors. Nested objects (dim, pos, tint, frame) are created once
+ * per proxy and hang off it under a hidden key.
+ */
+enum class EntityProperty {
+    DimW,
+    DimH,
+    PosX,
+    PosY,
+    TimeScale,
+    Tag,
+    SpriteScale,
+    TileHeight,
+    TileWidth,
+    TileOffsetX,
+    TileOffsetY,
+    FlipX,
+    FlipY,
+    Opacity,
+    TintR,
+    TintG,
+    TintB,
+    TintA,
+    FrameCurrent,
+    FrameCount,
+    Dim,
+    Pos,
+    Tint,
+    Frame
+};
+
+typedef struct PendingPosition {
+    entity_id_t entity_id;
+    CB_Point pos;
+} PendingPosition;
+
+// moving an entity may collide it with something, so positions written by a script are held here and applied once
+// the call returns, in the order the entities were first moved
+std::vector<PendingPosition> pending_positions;
+std::unordered_map<entity_id_t, size_t> pending_position_index;
+
+const CB_Point * FindPendingPosition(entity_id_t entity_id) {
+    auto it = pending_position_index.find(entity_id);
+    if (it == pending_position_index.end()) {
+        return nullptr;
+    }
+    return &pending_positions[it->second].pos;
+}
+
+CB_Point & GetPendingPosition(const std::shared_ptr<Entity> & entity) {
+    auto it = pending_position_index.find(entity->entity_id);
+    if (it != pending_position_index.end()) {
+        return pending_positions[it->second].pos;
+    }
+    pending_position_index.emplace(entity->entity_id, pending_positions.size());
+    pending_positions.push_back(PendingPosition{entity->entity_id, entity->dim.xy()});
+    return pending_positions.back().pos;
+}
+
+const char * GetNestedObjectKey(EntityProperty property) {
+    switch (property) {
+        case EntityProperty::Dim:
+            return CB_SCRIPT_HIDDEN_DIM;
+        case EntityProperty::Pos:
+            return CB_SCRIPT_HIDDEN_POS;
+        case EntityProperty::Tint:
+            return CB_SCRIPT_HIDDEN_TINT;
+        default:
+            return CB_SCRIPT_HIDDEN_FRAME;
+    }
+}
+
+std::shared_ptr<Entity> GetThisEntity(duk_context * context) {
+    // every entity accessor and method comes through here, so it's the script profiler's busiest sample point
+    CB_SCRIPT_SAMPLE_POINT(context);
+    duk_push_this(context);
+    entity_id_t entity_id = GetPropertyEntityId(context);
+    duk_pop(context);
+    return Engine::GetInstance().FindEntityById(entity_id);
+}
+
+Sprite * GetSprite(const std::shared_ptr<Entity> & entity) {
+    if (entity == nullptr || entity->GetEntityType() != EntityType::Sprite) {
+        return nullptr;
+    }
+    return static_cast<Sprite *>(entity.get());
+}
+
 /*
 * Functions callable from JavaScript code
 */
@@ -20,6 +110,12 @@ duk_ret_t cancel_callback(duk_context * context) {
         duk_del_prop_index(context, -1, callback_id);
     }
     duk_pop_2(context);
+    std::shared_ptr<Entity> entity = GetThisEntity(context);
+    if (entity != nullptr && entity->HasScript()) {
+        entity->script->CancelCallback(*entity, callback_id);
+    }
+    // the callback may belong to another entity, so always take it off the wheel
+    Engine::GetInstance().timers.Cancel(callback_id);
     CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
     return 0;
 }
@@ -73,11 +169,104 @@ duk_ret_t delay_callback(duk_context * context) { return queue_callback(context,
 
 duk_ret_t interval_callback(duk_context * context) { return queue_callback(context, false); }
 
-duk_ret_t mark_entity_destroyed(duk_context * context) {
-    CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
+duk_ret_t get_entity_property(duk_context * context) {
+    CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
+    EntityProperty property = static_cast<EntityProperty>(duk_get_current_magic(context));
+    std::shared_ptr<Entity> entity = GetThisEntity(context);
+    Sprite * sprite = GetSprite(entity);
+    if (entity == nullptr || (property >= EntityProperty::SpriteScale && sprite == nullptr)) {
+        // entity is gone (or inactive), a stale proxy just reads as undefined
+        duk_push_undefined(context);
+    } else {
+        const CB_Point * pending = FindPendingPosition(entity->entity_id);
+        switch (property) {
+            case EntityProperty::DimW:
+                duk_push_int(context, entity->dim.w);
+                break;
+            case EntityProperty::DimH:
+                duk_push_int(context, entity->dim.h);
+                break;
+            case EntityProperty::PosX:
+                duk_push_int(context, pending != nullptr ? pending->x : entity->dim.x);
+                break;
+            case EntityProperty::PosY:
+                duk_push_int(context, pending != nullptr ? pending->y : entity->dim.y);
+                break;
+            case EntityProperty::TimeScale:
+                duk_push_number(context, entity->time_scale);
+                break;
+            case EntityProperty::Tag:
+                duk_push_string(context, entity->tag.c_str());
+                break;
+            case EntityProperty::SpriteScale:
+                duk_push_number(context, sprite->sprite_scale);
+                break;
+            case EntityProperty::TileHeight:
+                duk_push_int(context, sprite->tile_height);
+                break;
+            case EntityProperty::TileWidth:
+                duk_push_int(context, sprite->tile_width);
+                break;
+            case EntityProperty::TileOffsetX:
+                duk_push_int(context, sprite->tile_offset_x);
+                break;
+            case EntityProperty::TileOffsetY:
+                duk_push_int(context, sprite->tile_offset_y);
+                break;
+            case EntityProperty::FlipX:
+                duk_push_boolean(context, sprite->flip_x ? 1 : 0);
+                break;
+            case EntityProperty::FlipY:
+                duk_push_boolean(context, sprite->flip_y ? 1 : 0);
+                break;
+            case EntityProperty::Opacity:
+                duk_push_number(context, static_cast<float>(sprite->tint_and_opacity.a) / 255.0f);
+                break;
+            case EntityProperty::TintR:
+                duk_push_int(context, sprite->tint_and_opacity.r);
+                break;
+            case EntityProperty::TintG:
+                duk_push_int(context, sprite->tint_and_opacity.g);
+                break;
+            case EntityProperty::TintB:
+                duk_push_int(context, sprite->tint_and_opacity.b);
+                break;
+            case EntityProperty::TintA:
+                duk_push_int(context, sprite->tint_and_opacity.a);
+                break;
+            case EntityProperty::FrameCurrent:
+                duk_push_int(context, sprite->GetFrame());
+                break;
+            case EntityProperty::FrameCount:
+                duk_push_int(context, sprite->GetFrameCount());
+                break;
+            default:
+                duk_push_undefined(context);
+                break;
+        }
+    }
+    CB_SCRIPT_ASSERT_STACK_RETURN1_END(context);
+    return 1;
+}
+
+duk_ret_t get_nested_object(duk_context * context) {
+    CB_SCRIPT_SAMPLE_POINT(context);
+    CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
+    EntityProperty property = static_cast<EntityProperty>(duk_get_current_magic(context));
     duk_push_this(context);
-    PushPropertyBool(context, CB_SCRIPT_HIDDEN_DESTROYED, true);
+    duk_get_prop_string(context, -1, GetNestedObjectKey(property));
+    duk_swap_top(context, -2);
     duk_pop(context);
+    CB_SCRIPT_ASSERT_STACK_RETURN1_END(context);
+    return 1;
+}
+
+duk_ret_t mark_entity_destroyed(duk_context * context) {
+    CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
+    std::shared_ptr<Entity> entity = GetThisEntity(context);
+    if (entity != nullptr) {
+        entity->MarkDestroy();
+    }
     CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
     return 0;
 }
@@ -155,6 +344,113 @@ duk_ret_t play_animation(duk_context * context) {
     return 0;
 }
 
+duk_ret_t set_entity_property(duk_context * context) {
+    CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
+    EntityProperty property = static_cast<EntityProperty>(duk_get_current_magic(context));
+    std::shared_ptr<Entity> entity = GetThisEntity(context);
+    Sprite * sprite = GetSprite(entity);
+    if (entity != nullptr && (property < EntityProperty::SpriteScale || sprite != nullptr)) {
+        switch (property) {
+            case EntityProperty::DimW:
+                entity->dim.w = duk_get_int(context, 0);
+                break;
+            case EntityProperty::DimH:
+                entity->dim.h = duk_get_int(context, 0);
+                break;
+            case EntityProperty::PosX:
+                GetPendingPosition(entity).x = duk_get_int(context, 0);
+                break;
+            case EntityProperty::PosY:
+                GetPendingPosition(entity).y = duk_get_int(context, 0);
+                break;
+            case EntityProperty::TimeScale:
+                entity->time_scale = static_cast<float>(duk_get_number(context, 0));
+                if (entity->HasScript()) {
+                    // pending delays and intervals run at the new scale from here on
+                    entity->script->RescheduleCallbacks(*entity);
+                }
+                break;
+            case EntityProperty::SpriteScale:
+                sprite->sprite_scale = static_cast<float>(duk_get_number(context, 0));
+                break;
+            case EntityProperty::TileHeight:
+                sprite->tile_height = duk_get_int(context, 0);
+                break;
+            case EntityProperty::TileWidth:
+                sprite->tile_width = duk_get_int(context, 0);
+                break;
+            case EntityProperty::TileOffsetX:
+                sprite->tile_offset_x = duk_get_int(context, 0);
+                break;
+            case EntityProperty::TileOffsetY:
+                sprite->tile_offset_y = duk_get_int(context, 0);
+                break;
+            case EntityProperty::FlipX:
+                sprite->flip_x = duk_to_boolean(context, 0) != 0;
+                break;
+            case EntityProperty::FlipY:
+                sprite->flip_y = duk_to_boolean(context, 0) != 0;
+                break;
+            case EntityProperty::Opacity:
+                sprite->tint_and_opacity.a =
+                    Clamp(static_cast<int>(255.0f * static_cast<float>(duk_get_number(context, 0))), 0, 255);
+                break;
+            case EntityProperty::TintR:
+                sprite->tint_and_opacity.r = duk_get_int(context, 0);
+                break;
+            case EntityProperty::TintG:
+                sprite->tint_and_opacity.g = duk_get_int(context, 0);
+                break;
+            case EntityProperty::TintB:
+                sprite->tint_and_opacity.b = duk_get_int(context, 0);
+                break;
+            case EntityProperty::FrameCurrent:
+                sprite->SetFrame(duk_get_int(context, 0));
+                break;
+            default:
+                // read-only
+                break;
+        }
+    }
+    CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
+    return 0;
+}
+
+duk_ret_t set_nested_object(duk_context * context) {
+    CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
+    // assigning a whole object (e.g. this.pos = {x: 1, y: 2}) copies its fields, the nested object itself is kept
+    EntityProperty property = static_cast<EntityProperty>(duk_get_current_magic(context));
+    std::shared_ptr<Entity> entity = GetThisEntity(context);
+    Sprite * sprite = GetSprite(entity);
+    if (entity != nullptr && duk_is_object(context, 0)) {
+        switch (property) {
+            case EntityProperty::Dim:
+                entity->dim.w = GetPropertyInt(context, "w", 0);
+                entity->dim.h = GetPropertyInt(context, "h", 0);
+                break;
+            case EntityProperty::Pos:
+                GetPendingPosition(entity) = CB_Point{GetPropertyInt(context, "x", 0), GetPropertyInt(context, "y", 0)};
+                break;
+            case EntityProperty::Tint:
+                if (sprite != nullptr) {
+                    sprite->tint_and_opacity.r = GetPropertyInt(context, "r", 0);
+                    sprite->tint_and_opacity.g = GetPropertyInt(context, "g", 0);
+                    sprite->tint_and_opacity.b = GetPropertyInt(context, "b", 0);
+                }
+                break;
+            case EntityProperty::Frame:
+                if (sprite != nullptr) {
+                    sprite->SetFrame(GetPropertyInt(context, "current", 0));
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
+    return 0;
+}
+
 duk_ret_t stop_animation(duk_context * context) {
     CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
     std::string anim_name{duk_get_string(context, 0)};
@@ -193,26 +489,46 @@ duk_ret_t stop_all_animation(duk_context * context) {
 }
 
 /*
- * Sprite entity push/pop
+ * Entity proxy creation
  */
+inline void PushEntityAccessor(duk_context * context, const char * property_name, EntityProperty property,
+                               bool writable = true) {
+    PushPropertyAccessor(context, property_name, get_entity_property, writable ? set_entity_property : nullptr,
+                         static_cast<int>(property));
+}
+
+inline void PushNestedObject(duk_context * context, const char * property_name, EntityProperty property) {
+    // expects the nested object on top of the stack and the proxy right behind it
+    duk_put_prop_string(context, -2, GetNestedObjectKey(property));
+    PushPropertyAccessor(context, property_name, get_nested_object, set_nested_object, static_cast<int>(property));
+}
+
 void ExtendEntityWithSprite(duk_context * context, std::shared_ptr<Sprite> sprite) {
     CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
     PushPropertyString(context, "entity_type", "sprite");
-    PushPropertyFloat(context, "sprite_scale", sprite->sprite_scale);
-    PushPropertyInt(context, "tile_height", sprite->tile_height);
-    PushPropertyInt(context, "tile_width", sprite->tile_width);
-    PushPropertyInt(context, "tile_offset_x", sprite->tile_offset_x);
-    PushPropertyInt(context, "tile_offset_y", sprite->tile_offset_y);
-    PushPropertyBool(context, "flip_x", sprite->flip_x);
-    PushPropertyBool(context, "flip_y", sprite->flip_y);
-    PushPropertyColor(context, "tint", sprite->tint_and_opacity);
-    PushPropertyFloat(context, "opacity", static_cast<float>(sprite->tint_and_opacity.a) / 255.0f);
+    PushEntityAccessor(context, "sprite_scale", EntityProperty::SpriteScale);
+    PushEntityAccessor(context, "tile_height", EntityProperty::TileHeight);
+    PushEntityAccessor(context, "tile_width", EntityProperty::TileWidth);
+    PushEntityAccessor(context, "tile_offset_x", EntityProperty::TileOffsetX);
+    PushEntityAccessor(context, "tile_offset_y", EntityProperty::TileOffsetY);
+    PushEntityAccessor(context, "flip_x", EntityProperty::FlipX);
+    PushEntityAccessor(context, "flip_y", EntityProperty::FlipY);
+    PushEntityAccessor(context, "opacity", EntityProperty::Opacity);
     PushPropertyFunction(context, "move_to", move_to, 4);
 
+    duk_push_object(context); // tint
+    PushPropertyEntityId(context, sprite->entity_id);
+    PushEntityAccessor(context, "r", EntityProperty::TintR);
+    PushEntityAccessor(context, "g", EntityProperty::TintG);
+    PushEntityAccessor(context, "b", EntityProperty::TintB);
+    PushEntityAccessor(context, "a", EntityProperty::TintA, false);
+    PushNestedObject(context, "tint", EntityProperty::Tint);
+
     duk_push_object(context); // frame
-    PushPropertyInt(context, "current", sprite->GetFrame());
-    PushPropertyInt(context, "count", sprite->GetFrameCount());
-    duk_put_prop_string(context, -2, "frame");
+    PushPropertyEntityId(context, sprite->entity_id);
+    PushEntityAccessor(context, "current", EntityProperty::FrameCurrent);
+    PushEntityAccessor(context, "count", EntityProperty::FrameCount, false);
+    PushNestedObject(context, "frame", EntityProperty::Frame);
 
     duk_push_object(context); // animation
     PushPropertyEntityId(context, sprite->entity_id);
@@ -224,175 +540,103 @@ void ExtendEntityWithSprite(duk_context * context, std::shared_ptr<Sprite> sprit
     CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
 }
 
-void RetrieveSpriteFromContext(duk_context * context, std::shared_ptr<Sprite> sprite, int stack_index) {
-    CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
-    sprite->sprite_scale = GetPropertyFloat(context, "sprite_scale", stack_index);
-    sprite->tile_height = GetPropertyInt(context, "tile_height", stack_index);
-    sprite->tile_width = GetPropertyInt(context, "tile_width", stack_index);
-    sprite->tile_offset_x = GetPropertyInt(context, "tile_offset_x", stack_index);
-    sprite->tile_offset_y = GetPropertyInt(context, "tile_offset_y", stack_index);
-    sprite->flip_x = GetPropertyBool(context, "flip_x", stack_index);
-    sprite->flip_y = GetPropertyBool(context, "flip_y", stack_index);
-    sprite->tint_and_opacity = GetPropertyColor(context, "tint", stack_index);
-    float opacity = GetPropertyFloat(context, "opacity", stack_index);
-    sprite->tint_and_opacity.a = Clamp(static_cast<int>(255.0f * opacity), 0, 255);
-    duk_get_prop_string(context, stack_index, "frame");
-    int current_frame = GetPropertyInt(context, "current", -1);
-    sprite->SetFrame(current_frame);
-    duk_pop(context); // frame
-    CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
+void PushEntityProxy(duk_context * context, std::shared_ptr<Entity> entity) {
+    CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
+    duk_push_object(context); // root
+    PushPropertyEntityId(context, entity->entity_id);
+
+    duk_push_object(context); // dim
+    PushPropertyEntityId(context, entity->entity_id);
+    PushEntityAccessor(context, "w", EntityProperty::DimW);
+    PushEntityAccessor(context, "h", EntityProperty::DimH);
+    PushNestedObject(context, "dim", EntityProperty::Dim);
+
+    duk_push_object(context); // pos
+    PushPropertyEntityId(context, entity->entity_id);
+    PushEntityAccessor(context, "x", EntityProperty::PosX);
+    PushEntityAccessor(context, "y", EntityProperty::PosY);
+    PushNestedObject(context, "pos", EntityProperty::Pos);
+
+    PushEntityAccessor(context, "tag", EntityProperty::Tag, false);
+    PushEntityAccessor(context, "time_scale", EntityProperty::TimeScale);
+    PushPropertyFunction(context, "destroy", mark_entity_destroyed);
+    PushPropertyFunction(context, "delay", delay_callback, 2);
+    PushPropertyFunction(context, "interval", interval_callback, 2);
+    PushPropertyFunction(context, "cancel", cancel_callback, 1);
+
+    if (entity->GetEntityType() == EntityType::Sprite) {
+        ExtendEntityWithSprite(context, std::dynamic_pointer_cast<Sprite>(entity));
+    }
+    CB_SCRIPT_ASSERT_STACK_RETURN1_END(context);
 }
 /*
  * End of support functions
  */
 }
 
-void ClearEntitiesInContext(duk_context * context) {
-    CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
-    duk_push_global_stash(context);
-    duk_del_prop_string(context, -1, CB_SCRIPT_ENTITY_STASH_ARRAY);
-    duk_pop(context);
-    CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
+void ApplyPendingEntityChanges() {
+    if (pending_positions.empty()) {
+        return;
+    }
+    std::vector<PendingPosition> positions;
+    positions.swap(pending_positions);
+    pending_position_index.clear();
+    for (auto & pending : positions) {
+        std::shared_ptr<Entity> entity = Engine::GetInstance().FindEntityById(pending.entity_id);
+        if (entity != nullptr) {
+            // set position (may result in collisions)
+            entity->SetPosition(pending.pos.x, pending.pos.y);
+        }
+    }
 }
 
 void CreateEntityInContext(duk_context * context, std::shared_ptr<Entity> entity) {
+    // duktape has no weak map, so the stash holds proxies strongly; whoever unloads an entity has to call
+    // ReleaseEntityInContext (through ScriptEngine::ReleaseEntity) or its proxy stays alive
     CB_SCRIPT_ASSERT_STACK_RETURN1_BEGIN(context);
-    duk_push_global_stash(context); // will save to the global stash when we're done
+    duk_push_global_stash(context);
 
-    // create array if it doesn't exist
-    duk_get_prop_string(context, -1, CB_SCRIPT_ENTITY_STASH_ARRAY);
-    if (!duk_is_array(context, -1)) {
+    // create the proxy map if it doesn't exist
+    if (duk_get_prop_string(context, -1, CB_SCRIPT_ENTITY_STASH) == 0) {
         duk_pop(context);
-        duk_push_array(context);
-        duk_put_prop_string(context, -2, CB_SCRIPT_ENTITY_STASH_ARRAY);
-        duk_get_prop_string(context, -1, CB_SCRIPT_ENTITY_STASH_ARRAY);
-    }
-
-    // swap the stash array with the global stash and pop it off
-    duk_swap_top(context, -2);
-    duk_pop(context);
-
-    // are we already on the stash?
-    int found_stash_idx = -1;
-    int num_props = duk_get_length(context, -1);
-    for (int i = 0; i < num_props; i++) {
-        if (duk_get_prop_index(context, -1, i) != 0) {
-            if (duk_is_object(context, -1)) {
-                duk_get_prop_string(context, -1, CB_SCRIPT_HIDDEN_ENTITYID);
-                entity_id_t eid = duk_get_int(context, -1);
-                duk_pop_2(context);
-                if (eid == entity->entity_id) {
-                    found_stash_idx = i;
-                    break;
-                }
-            } else {
-                duk_pop(context);
-            }
-        } else {
-            LOG_ERR("CreateEntityInContext error retrieving property at index " + std::to_string(i));
-            duk_pop(context);
-        }
+        duk_push_object(context);
+        duk_dup_top(context);
+        duk_put_prop_string(context, -3, CB_SCRIPT_ENTITY_STASH);
     }
 
-    if (found_stash_idx == -1) {
-        // doesn't exist, create a new one
-        duk_push_object(context); // root
-        duk_push_object(context); // dim
-        PushPropertyInt(context, "w", entity->dim.w);
-        PushPropertyInt(context, "h", entity->dim.h);
-        duk_put_prop_string(context, -2, "dim");
-        PushPropertyPoint(context, "pos", entity->dim.xy());
-        PushPropertyEntityId(context, entity->entity_id);
-        PushPropertyString(context, "tag", entity->tag);
-        PushPropertyFloat(context, "time_scale", entity->time_scale);
-        PushPropertyFunction(context, "destroy", mark_entity_destroyed);
-        PushPropertyFunction(context, "delay", delay_callback, 2);
-        PushPropertyFunction(context, "interval", interval_callback, 2);
-        PushPropertyFunction(context, "cancel", cancel_callback, 1);
-
-        if (entity->GetEntityType() == EntityType::Sprite) {
-            ExtendEntityWithSprite(context, std::dynamic_pointer_cast<Sprite>(entity));
-        }
-
-        // save to the end of the stash array so we can grab it after method call
-        duk_put_prop_index(context, -2, num_props);
-
-        // now put the entity back on the top of the stack
-        duk_get_prop_index(context, -1, num_props);
-    } else {
-        // exists, put it on the stack
-        duk_get_prop_index(context, -1, found_stash_idx);
+    // proxies are created once per entity and reused for every call after that
+    if (duk_get_prop_index(context, -1, entity->entity_id) == 0) {
+        duk_pop(context);
+        PushEntityProxy(context, entity);
+        duk_dup_top(context);
+        duk_put_prop_index(context, -3, entity->entity_id);
     }
 
-    // swap the entity with the stash array and then pop the stash array off
-    duk_swap_top(context, -2);
-    duk_pop(context);
+    // leave only the proxy on the stack
+    duk_swap_top(context, -3);
+    duk_pop_2(context);
 
     CB_SCRIPT_ASSERT_STACK_RETURN1_END(context);
 }
 
-void RetrieveEntityFromContext(duk_context * context, std::shared_ptr<Entity> entity) {
+void ReleaseEntityInContext(duk_context * context, entity_id_t entity_id) {
     CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
     duk_push_global_stash(context);
-    if (duk_get_prop_string(context, -1, CB_SCRIPT_ENTITY_STASH_ARRAY)) {
-        // got the array, now find the entity
-        int found_stash_idx = -1;
-        int num_props = duk_get_length(context, -1);
-        for (int i = 0; i < num_props; i++) {
-            if (duk_get_prop_index(context, -1, i) != 0) {
-                if (duk_is_object(context, -1)) {
-                    duk_get_prop_string(context, -1, CB_SCRIPT_HIDDEN_ENTITYID);
-                    entity_id_t eid = duk_get_int(context, -1);
-                    duk_pop_2(context);
-                    if (eid == entity->entity_id) {
-                        found_stash_idx = i;
-                        break;
-                    }
-                } else {
-                    duk_pop(context);
-                }
-            } else {
-                LOG_ERR("RetrieveEntityFromContext error retrieving property at index " + std::to_string(i));
-                duk_pop(context);
-            }
-        }
-
-        if (found_stash_idx > -1) {
-            duk_get_prop_index(context, -1, found_stash_idx);
-
-            RetrieveEntityFromContextAt(context, entity);
-
-            duk_pop(context); // entity
-        } else {
-            LOG_ERR("Script::RetrieveEntityFromContext unable to find entity in stash array");
-        }
-    } else {
-        LOG_ERR("Script::RetrieveEntityFromContext unable to retrieve stash array");
+    if (duk_get_prop_string(context, -1, CB_SCRIPT_ENTITY_STASH) != 0) {
+        duk_del_prop_index(context, -1, entity_id);
     }
-    duk_pop_2(context); // stash and array
-    CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
-}
-
-void RetrieveEntityFromContextAt(duk_context * context, std::shared_ptr<Entity> entity, int stack_index) {
-    CB_SCRIPT_ASSERT_STACK_CLEAN_BEGIN(context);
-    if (duk_is_object(context, stack_index)) {
-        // only mutable properties are retrieved
-        CB_Point new_dim = GetPropertyRectDimOnly(context, "dim", stack_index);
-        entity->dim.wh(new_dim);
-        CB_Point new_pos = GetPropertyPoint(context, "pos", stack_index);
-        entity->time_scale = GetPropertyFloat(context, "time_scale", stack_index);
-
-        // set position (may result in collisions)
-        entity->SetPosition(new_pos.x, new_pos.y);
-
-        // special case: "destroyed flag"
-        bool destroyed = GetPropertyBool(context, CB_SCRIPT_HIDDEN_DESTROYED, stack_index);
-        if (destroyed) {
-            entity->MarkDestroy();
-        }
+    duk_pop_2(context);
 
-        if (entity->GetEntityType() == EntityType::Sprite) {
-            RetrieveSpriteFromContext(context, std::dynamic_pointer_cast<Sprite>(entity), stack_index);
+    // a position still pending for this entity has nowhere to go
+    auto it = pending_position_index.find(entity_id);
+    if (it != pending_position_index.end()) {
+        size_t index = it->second;
+        pending_position_index.erase(it);
+        pending_positions.erase(pending_positions.begin() + index);
+        for (auto & indexed : pending_position_index) {
+            if (indexed.second > index) {
+                indexed.second--;
+            }
         }
     }
     CB_SCRIPT_ASSERT_STACK_CLEAN_END(context);
@@ -9,6 +9,19 @@ Sprite::Sprite() { this->debug = Engine::GetInstance().config->debug.draw_sprite
 
 Sprite::~Sprite() {}
 
+void Sprite::AnimateConcurrently(float delta_time) {
+    // same conditions (and time scaling) as Entity::Update
+    if (!this->IsActive() || this->time_scale == 0.f) {
+        return;
+    }
+    float scaled_delta_time = delta_time * this->time_scale;
+    for (auto & animation : this->animations) {
+        if (!animation->IsDestroyed() && animation->CanAnimateConcurrently()) {
+            animation->Animate(shared_from_this(), scaled_delta_time);
+        }
+    }
+}
+
 CB_Rect Sprite::GetFrameRect() const {
     CB_Rect frame_rect;
     frame_rect.x = this->tile_offset_x + this->tile_width * (this->current_frame % this->sprite_sheet_cols);
@@ -28,20 +41,10 @@ void Sprite::NotifyLoaded() {
     }
 
     if (!this->sprite_sheet_path.empty()) {
-        EngineEventQueue::GetInstance().QueuePreUpdate((PreUpdateEvent)[this]() {
-            LOG_INFO("Sprite::NotifyLoaded(pre-update) attempting to load sprite sheet " + this->sprite_sheet_path);
-            this->sprite_sheet =
-                Engine::GetInstance().textures.GetTexture(this->sprite_sheet_path);
-            if (this->sprite_sheet == nullptr) {
-                LOG_ERR("Sprite::NotifyLoaded(pre-update) unable to load sprite sheet");
-            } else {
-                int w, h;
-                SDL_QueryTexture(this->sprite_sheet.get(), NULL, NULL, &w, &h);
-                this->sprite_sheet_cols = (w - this->tile_offset_x) / this->tile_width;
-                this->sprite_sheet_rows = (h - this->tile_offset_y) / this->tile_height;
-            }
-            this->sprite_sheet_loaded = true;
-        });
+        // decoded in the background; OnStart picks up the texture once it has been uploaded
+        LOG_INFO("Sprite::NotifyLoaded attempting to load sprite sheet " + this->sprite_sheet_path);
+        this->pending_sprite_sheet = Engine::GetInstance().textures.GetTextureAsync(this->sprite_sheet_path);
+        this->sprite_sheet_ordinal = Engine::GetInstance().textures.GetTextureOrdinal(this->sprite_sheet_path);
     }
 
     if (!this->script_path.empty()) {
@@ -54,24 +57,46 @@ void Sprite::NotifyLoaded() {
     }
 }
 
+unsigned int Sprite::GetRenderLayers() const {
+    unsigned int layers = this->sprite_sheet != nullptr ? ZIndexMask(ZIndex::Midground) : 0;
+    if (this->debug) {
+        layers |= ZIndexMask(ZIndex::Foreground);
+    }
+    return layers;
+}
+
 void Sprite::NotifyUnloaded() {
     LOG_INFO("Sprite::NotifyUnloaded sprite was unloaded " + this->sprite_name);
     this->state = EntityState::Unloaded;
 }
 
+CB_Rect Sprite::GetRenderDestRect(const CB_ViewClippingInfo & clip_rect) const {
+    // FIXME: hack to prevent sprites from getting squished (GetFrameRect() needs to adjust for clipping)
+    CB_Rect dst_rect = clip_rect.dest;
+    dst_rect.x -= clip_rect.source.x;
+    dst_rect.y -= clip_rect.source.y;
+    dst_rect.w = this->dim.w;
+    dst_rect.h = this->dim.h;
+    return dst_rect;
+}
+
 void Sprite::OnRender(SDL_Renderer * renderer, const CB_ViewClippingInfo & clip_rect) {
     if (this->sprite_sheet != nullptr && clip_rect.z_index == ZIndex::Midground) {
-        // FIXME: hack to prevent sprites from getting squished (GetFrameRect() needs to adjust for clipping)
-        CB_Rect dst_rect = clip_rect.dest;
-        dst_rect.x -= clip_rect.source.x;
-        dst_rect.y -= clip_rect.source.y;
-        dst_rect.w = this->dim.w;
-        dst_rect.h = this->dim.h;
         SDL_SetTextureColorMod(this->sprite_sheet.get(), this->tint_and_opacity.r, this->tint_and_opacity.g, this->tint_and_opacity.b);
         SDL_SetTextureAlphaMod(this->sprite_sheet.get(), this->tint_and_opacity.a);
-        SDLx::SDL_RenderTextureClipped(renderer, this->sprite_sheet.get(), this->GetFrameRect(), dst_rect,
-                                        this->flip_x, this->flip_y);
+        SDLx::SDL_RenderTextureClipped(renderer, this->sprite_sheet.get(), this->GetFrameRect(),
+                                       this->GetRenderDestRect(clip_rect), this->flip_x, this->flip_y);
+    }
+}
+
+bool Sprite::OnRenderBatched(SpriteBatch & batch, const CB_ViewClippingInfo & clip_rect) {
+    // only the sprite sheet pass batches, debug overlays are drawn immediately
+    if (this->sprite_sheet != nullptr && clip_rect.z_index == ZIndex::Midground) {
+        batch.Draw(Engine::GetInstance().GetRenderer(), this->sprite_sheet.get(), this->GetFrameRect(),
+                   this->GetRenderDestRect(clip_rect), this->tint_and_opacity, this->flip_x, this->flip_y);
+        return true;
     }
+    return false;
 }
 
 void Sprite::OnDebugRender(SDL_Renderer * renderer, const CB_ViewClippingInfo & clip_rect) {
@@ -106,9 +131,24 @@ void Sprite::SetPosition(int new_x, int new_y) {
 
     this->dim.x = new_xy.x - this->collision_box.x;
     this->dim.y = new_xy.y - this->collision_box.y;
+    this->UpdateGridPosition();
 }
 
 bool Sprite::OnStart() {
+    if (this->pending_sprite_sheet != nullptr && this->pending_sprite_sheet->IsResolved()) {
+        this->sprite_sheet = this->pending_sprite_sheet->GetTexture();
+        this->pending_sprite_sheet.reset();
+        if (this->sprite_sheet == nullptr) {
+            LOG_ERR("Sprite::OnStart unable to load sprite sheet");
+        } else {
+            int w, h;
+            SDL_QueryTexture(this->sprite_sheet.get(), NULL, NULL, &w, &h);
+            this->sprite_sheet_cols = (w - this->tile_offset_x) / this->tile_width;
+            this->sprite_sheet_rows = (h - this->tile_offset_y) / this->tile_height;
+        }
+        this->sprite_sheet_loaded = true;
+    }
+
     // delay start until resources loaded
     if (this->sprite_sheet_loaded && this->script_loaded) {
         return true;
@@ -117,11 +157,15 @@ bool Sprite::OnStart() {
 }
 
 void Sprite::OnUpdate(float delta_time) {
+    // animations that can run concurrently are left for the engine's parallel animation pass
+    bool skip_concurrent = Engine::GetInstance().config->threading.parallel_animation;
     for (auto it = this->animations.begin(); it != this->animations.end();) {
         if ((*it)->IsDestroyed()) {
             it = this->animations.erase(it);
         } else {
-            (*it)->Animate(shared_from_this(), delta_time);
+            if (!skip_concurrent || !(*it)->CanAnimateConcurrently()) {
+                (*it)->Animate(shared_from_this(), delta_time);
+            }
             it++;
         }
     }
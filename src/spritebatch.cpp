@@ -0,0 +1,86 @@
+#include <utility>
+
+#include <cb/critterbits.hpp>
+
+namespace Critterbits {
+namespace {
+#ifdef CB_SPRITE_BATCHING
+inline SDL_Vertex MakeVertex(float x, float y, const SDL_Color & color, float u, float v) {
+    SDL_Vertex vertex;
+    vertex.position.x = x;
+    vertex.position.y = y;
+    vertex.color = color;
+    vertex.tex_coord.x = u;
+    vertex.tex_coord.y = v;
+    return vertex;
+}
+#endif
+}
+
+void SpriteBatch::Draw(SDL_Renderer * renderer, SDL_Texture * texture, const CB_Rect & source, const CB_Rect & dest,
+                       const CB_Color & tint, bool flip_x, bool flip_y) {
+#ifdef CB_SPRITE_BATCHING
+    if (texture != this->texture) {
+        this->Flush(renderer);
+        this->texture = texture;
+        int w, h;
+        if (SDL_QueryTexture(texture, nullptr, nullptr, &w, &h) != 0 || w == 0 || h == 0) {
+            LOG_SDL_ERR("SpriteBatch::Draw SDL_QueryTexture");
+            w = 1;
+            h = 1;
+        }
+        this->texture_w = static_cast<float>(w);
+        this->texture_h = static_cast<float>(h);
+    }
+
+    SDL_Color color{static_cast<Uint8>(Clamp(tint.r, 0, 255)), static_cast<Uint8>(Clamp(tint.g, 0, 255)),
+                    static_cast<Uint8>(Clamp(tint.b, 0, 255)), static_cast<Uint8>(Clamp(tint.a, 0, 255))};
+    float u1 = source.x / this->texture_w;
+    float v1 = source.y / this->texture_h;
+    float u2 = source.right() / this->texture_w;
+    float v2 = source.bottom() / this->texture_h;
+    if (flip_x) {
+        std::swap(u1, u2);
+    }
+    if (flip_y) {
+        std::swap(v1, v2);
+    }
+    float x1 = static_cast<float>(dest.x);
+    float y1 = static_cast<float>(dest.y);
+    float x2 = static_cast<float>(dest.right());
+    float y2 = static_cast<float>(dest.bottom());
+
+    int base = static_cast<int>(this->vertices.size());
+    this->vertices.push_back(MakeVertex(x1, y1, color, u1, v1));
+    this->vertices.push_back(MakeVertex(x2, y1, color, u2, v1));
+    this->vertices.push_back(MakeVertex(x2, y2, color, u2, v2));
+    this->vertices.push_back(MakeVertex(x1, y2, color, u1, v2));
+    for (int offset : {0, 1, 2, 0, 2, 3}) {
+        this->indices.push_back(base + offset);
+    }
+#else
+    SDL_SetTextureColorMod(texture, tint.r, tint.g, tint.b);
+    SDL_SetTextureAlphaMod(texture, tint.a);
+    SDLx::SDL_RenderTextureClipped(renderer, texture, source, dest, flip_x, flip_y);
+    Engine::GetInstance().counters.SubmittedSpriteBatch();
+#endif
+}
+
+void SpriteBatch::Flush(SDL_Renderer * renderer) {
+#ifdef CB_SPRITE_BATCHING
+    if (!this->indices.empty()) {
+        // vertex colors carry tint/opacity, so make sure a leftover texture mod doesn't multiply into them
+        SDL_SetTextureColorMod(this->texture, 255, 255, 255);
+        SDL_SetTextureAlphaMod(this->texture, 255);
+        if (SDL_RenderGeometry(renderer, this->texture, this->vertices.data(), static_cast<int>(this->vertices.size()),
+                               this->indices.data(), static_cast<int>(this->indices.size())) != 0) {
+            LOG_SDL_ERR("SpriteBatch::Flush SDL_RenderGeometry");
+        }
+        Engine::GetInstance().counters.SubmittedSpriteBatch();
+        this->vertices.clear();
+        this->indices.clear();
+    }
+#endif
+    this->texture = nullptr;
+}
+}
\ No newline at end of file
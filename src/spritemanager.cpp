@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <cb/critterbits.hpp>
 
 namespace Critterbits {
@@ -10,101 +12,161 @@ std::string SpriteManager::GetSpriteSheetPath(const std::string & asset_name) co
     return CB_SPRITE_PATH PATH_SEP_STR + asset_name;
 }
 
-bool SpriteManager::LoadQueuedSprites() {
-    bool success = true;
+void SpriteManager::AddSprite(std::shared_ptr<Sprite> sprite) {
+    sprite->sprite_index = this->sprites.size();
+    this->sprites.push_back(std::move(sprite));
+}
 
-    for (auto it = this->queued_sprites.begin(); it != this->queued_sprites.end();) {
-        const QueuedSprite & qsprite = *it;
-        std::string sprite_name{qsprite.name};
-        std::string sprite_path_current{this->GetSpritePath(sprite_name)};
-        LOG_INFO("SpriteManager::LoadQueuedSprites attempting to load " + sprite_path_current);
+std::shared_ptr<const SpritePrefab> SpriteManager::GetPrefab(const std::string & sprite_name) {
+    auto it = this->prefabs.find(sprite_name);
+    if (it != this->prefabs.end()) {
+        return it->second;
+    }
+
+    std::string sprite_path{this->GetSpritePath(sprite_name)};
+    LOG_INFO("SpriteManager::GetPrefab attempting to load " + sprite_path);
+    std::shared_ptr<const SpritePrefab> prefab;
+    auto sprite_file = Engine::GetInstance().GetResourceLoader()->OpenTextResource(sprite_path);
+    Toml::TomlParser parser{sprite_file};
+    if (parser.IsReady()) {
+        prefab = this->ParsePrefab(parser, sprite_path);
+    } else {
+        LOG_ERR("SpriteManager::GetPrefab unable to load sprite from " + sprite_path);
+    }
+    // bad sprites are cached too, to prevent re-reading the file for every spawn
+    this->prefabs.insert(std::make_pair(sprite_name, prefab));
+    return prefab;
+}
 
-        auto sprite_file = Engine::GetInstance().GetResourceLoader()->OpenTextResource(sprite_path_current);
-        Toml::TomlParser parser{sprite_file};
-        if (parser.IsReady()) {
-            std::shared_ptr<Sprite> new_sprite = std::make_shared<Sprite>();
-            new_sprite->sprite_name = qsprite.name;
-            new_sprite->dim.x = qsprite.at.x;
-            new_sprite->dim.y = qsprite.at.y;
-            new_sprite->sprite_path = sprite_path_current;
+std::shared_ptr<Sprite> SpriteManager::InstantiatePrefab(const SpritePrefab & prefab,
+                                                         const QueuedSprite & qsprite) const {
+    std::shared_ptr<Sprite> new_sprite = std::make_shared<Sprite>();
+    new_sprite->sprite_name = qsprite.name;
+    new_sprite->dim.x = qsprite.at.x;
+    new_sprite->dim.y = qsprite.at.y;
+    new_sprite->sprite_path = prefab.sprite_path;
+    new_sprite->sprite_sheet_path = prefab.sprite_sheet_path;
+    new_sprite->script_path = prefab.script_path;
+    new_sprite->tag = prefab.tag;
+    new_sprite->sprite_scale = prefab.sprite_scale;
+    new_sprite->tile_height = prefab.tile_height;
+    new_sprite->tile_width = prefab.tile_width;
+    new_sprite->tile_offset_x = prefab.tile_offset_x;
+    new_sprite->tile_offset_y = prefab.tile_offset_y;
+    new_sprite->tint_and_opacity = prefab.tint_and_opacity;
+    new_sprite->collision = prefab.collision;
+    new_sprite->collision_box = prefab.collision_box;
 
-            // parse sprite features
-            this->ParseSprite(parser, new_sprite);
+    // animation state is per sprite, the key frames themselves are shared
+    new_sprite->animations.reserve(prefab.animations.size());
+    for (auto & animation_def : prefab.animations) {
+        std::shared_ptr<Animation::KeyFrameAnimation> anim =
+            std::make_shared<Animation::KeyFrameAnimation>(animation_def.name, animation_def.key_frames);
+        anim->loop = animation_def.loop;
+        if (animation_def.auto_play) {
+            anim->Play();
+        }
+        new_sprite->animations.push_back(std::move(anim));
+    }
+    return new_sprite;
+}
 
-            // notify new sprite that it's been loaded
-            new_sprite->NotifyLoaded();
+bool SpriteManager::LoadQueuedSprites() {
+    bool success = true;
 
-            this->sprites.push_back(std::move(new_sprite));
+    // take the whole queue at once rather than erasing loaded sprites from the front one at a time
+    std::vector<QueuedSprite> queued;
+    queued.swap(this->queued_sprites);
+    this->sprites.reserve(this->sprites.size() + queued.size());
+    std::vector<BoxCollider *> new_colliders;
 
-            it = this->queued_sprites.erase(it);
-        } else {
-            LOG_ERR("SpriteManager::LoadQueuedSprites unable to load sprite from " + sprite_path_current);
+    for (auto & qsprite : queued) {
+        std::shared_ptr<const SpritePrefab> prefab = this->GetPrefab(qsprite.name);
+        if (prefab == nullptr) {
+            LOG_ERR("SpriteManager::LoadQueuedSprites unable to spawn sprite " + qsprite.name);
             success = false;
-            it++;
+            continue;
         }
-    }
 
-    if (success) {
-        this->new_sprites = false;
+        std::shared_ptr<Sprite> new_sprite = this->InstantiatePrefab(*prefab, qsprite);
+
+        // notify new sprite that it's been loaded
+        new_sprite->NotifyLoaded();
+
+        // make the sprite visible to collision broadphase (done for the whole batch below)
+        if (new_sprite->collision != CollisionType::None) {
+            new_colliders.push_back(new_sprite.get());
+        }
+        Engine::GetInstance().entities.Register(new_sprite);
+
+        this->AddSprite(std::move(new_sprite));
     }
+    this->colliders->InsertAll(new_colliders, Engine::GetInstance().config->threading.parallel_colliders);
+
+    // sprites that failed to load are dropped, a later spawn() still needs to queue a new load
+    this->new_sprites = false;
 
     return success;
 }
 
-void SpriteManager::ParseSprite(const Toml::TomlParser & parser, std::shared_ptr<Sprite> sprite) const {
-    sprite->tag = parser.GetTableString("sprite.tag");
-    sprite->script_path = parser.GetTableString("sprite.script");
-    if (!sprite->script_path.empty()) {
-        sprite->script_path = this->GetSpriteSheetPath(sprite->script_path);
+std::shared_ptr<SpritePrefab> SpriteManager::ParsePrefab(const Toml::TomlParser & parser,
+                                                         const std::string & sprite_path) const {
+    std::shared_ptr<SpritePrefab> prefab = std::make_shared<SpritePrefab>();
+    prefab->sprite_path = sprite_path;
+    prefab->tag = parser.GetTableString("sprite.tag");
+    prefab->script_path = parser.GetTableString("sprite.script");
+    if (!prefab->script_path.empty()) {
+        prefab->script_path = this->GetSpriteSheetPath(prefab->script_path);
     }
-    sprite->tint_and_opacity = parser.GetTableColor("sprite.tint", CB_Color{255,255,255,255});
+    prefab->tint_and_opacity = parser.GetTableColor("sprite.tint", CB_Color{255,255,255,255});
     float opacity = parser.GetTableFloat("sprite.opacity", 1.0f);
-    sprite->tint_and_opacity.a = Clamp(opacity * 255, 0, 255);
-    sprite->sprite_sheet_path = parser.GetTableString("sprite_sheet.image");
+    prefab->tint_and_opacity.a = Clamp(opacity * 255, 0, 255);
+    prefab->sprite_sheet_path = parser.GetTableString("sprite_sheet.image");
     // prepend the asset path to the sprite sheet path if one was set
-    if (!sprite->sprite_sheet_path.empty()) {
-        sprite->sprite_sheet_path = this->GetSpriteSheetPath(sprite->sprite_sheet_path);
+    if (!prefab->sprite_sheet_path.empty()) {
+        prefab->sprite_sheet_path = this->GetSpriteSheetPath(prefab->sprite_sheet_path);
     }
-    sprite->tile_height = parser.GetTableInt("sprite_sheet.tile_height");
-    sprite->tile_width = parser.GetTableInt("sprite_sheet.tile_width");
-    sprite->tile_offset_x = parser.GetTableInt("sprite_sheet.tile_offset_x");
-    sprite->tile_offset_y = parser.GetTableInt("sprite_sheet.tile_offset_y");
-    sprite->sprite_scale = parser.GetTableFloat("sprite_sheet.sprite_scale", 1.0f);
+    prefab->tile_height = parser.GetTableInt("sprite_sheet.tile_height");
+    prefab->tile_width = parser.GetTableInt("sprite_sheet.tile_width");
+    prefab->tile_offset_x = parser.GetTableInt("sprite_sheet.tile_offset_x");
+    prefab->tile_offset_y = parser.GetTableInt("sprite_sheet.tile_offset_y");
+    prefab->sprite_scale = parser.GetTableFloat("sprite_sheet.sprite_scale", 1.0f);
     std::string collide = parser.GetTableString("2d.collision");
     if (collide == "collide") {
-        sprite->collision = CollisionType::Collide;
+        prefab->collision = CollisionType::Collide;
     } else if (collide == "trigger") {
-        sprite->collision = CollisionType::Trigger;
+        prefab->collision = CollisionType::Trigger;
     }
-    sprite->collision_box = parser.GetTableRect("2d.box");
+    prefab->collision_box = parser.GetTableRect("2d.box");
     // animations
-    parser.IterateTableArray("animation", [&sprite](const Toml::TomlParser & table) {
-        std::string animation_name = table.GetTableString("name");
-        if (!animation_name.empty()) {
-            std::shared_ptr<Animation::KeyFrameAnimation> anim = std::make_shared<Animation::KeyFrameAnimation>(animation_name);
-            anim->loop = table.GetTableBool("loop");
-            table.IterateTableArray("frames", [&anim](const Toml::TomlParser & table) {
+    parser.IterateTableArray("animation", [&prefab](const Toml::TomlParser & table) {
+        SpritePrefab::AnimationDef animation_def;
+        animation_def.name = table.GetTableString("name");
+        if (!animation_def.name.empty()) {
+            std::shared_ptr<Animation::KeyFrameList> key_frames = std::make_shared<Animation::KeyFrameList>();
+            animation_def.loop = table.GetTableBool("loop");
+            table.IterateTableArray("frames", [&key_frames](const Toml::TomlParser & table) {
                 Animation::KeyFrame key_frame{
                     table.GetTableString("prop"),
                     table.GetTableString("val"),
                     table.GetTableInt("dur")
                 };
                 if (key_frame.property.empty()) {
-                    LOG_ERR("SpriteManager::LoadQueuedSprites animation key frame must have a property");
+                    LOG_ERR("SpriteManager::ParsePrefab animation key frame must have a property");
                     return;
                 }
                 if (key_frame.duration < 0) {
-                    LOG_ERR("SpriteManager::LoadQueuedSprites animation key frame cannot have duration less than zero");
+                    LOG_ERR("SpriteManager::ParsePrefab animation key frame cannot have duration less than zero");
                     return;
                 }
-                anim->AddKeyFrame(key_frame);
+                key_frames->push_back(key_frame);
             });
-            if (table.GetTableBool("auto_play")) {
-                anim->Play();
-            }
-            sprite->animations.push_back(std::move(anim));
+            animation_def.auto_play = table.GetTableBool("auto_play");
+            animation_def.key_frames = std::move(key_frames);
+            prefab->animations.push_back(std::move(animation_def));
         }
     });
+    return prefab;
 }
 
 void SpriteManager::QueueSprite(const QueuedSprite & queued_sprite) {
@@ -119,14 +181,32 @@ void SpriteManager::QueueSprite(const QueuedSprite & queued_sprite) {
     }
 }
 
-void SpriteManager::UnloadSprite(std::shared_ptr<Sprite> sprite) {
-    for (auto it = this->sprites.begin(); it != this->sprites.end();) {
-        if (sprite->entity_id == (*it)->entity_id) {
-            this->sprites.erase(it);
-            break;
-        }
-        it++;
+void SpriteManager::RemoveUnloadedSprites() {
+    if (!this->unloaded_sprites) {
+        return;
     }
+    this->sprites.erase(std::remove(this->sprites.begin(), this->sprites.end(), nullptr), this->sprites.end());
+    for (size_t i = 0; i < this->sprites.size(); i++) {
+        this->sprites[i]->sprite_index = i;
+    }
+    this->unloaded_sprites = false;
+}
+
+bool SpriteManager::UnloadSprite(std::shared_ptr<Sprite> sprite) {
+    size_t index = sprite->sprite_index;
+    if (index >= this->sprites.size() || this->sprites[index] != sprite) {
+        return false;
+    }
+
+    // leave the slot empty rather than shifting or swapping, so update and draw order stay in insertion order;
+    // RemoveUnloadedSprites() closes the gaps once per frame
+    this->sprites[index] = nullptr;
+    this->unloaded_sprites = true;
+
+    this->colliders->Remove(sprite.get());
+    Engine::GetInstance().entities.Unregister(sprite->entity_id);
+    Engine::GetInstance().scripts.ReleaseEntity(sprite->entity_id);
     sprite->NotifyUnloaded();
+    return true;
 }
 }
\ No newline at end of file
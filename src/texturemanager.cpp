@@ -60,17 +60,31 @@ std::shared_ptr<SDL_Texture> TextureManager::CreateTargetTexture(int w, int h, f
     return std::move(texture_ptr);
 }
 
+std::string TextureManager::GetFinalPath(const std::string & asset_path, const std::string & relative_to_file) const {
+    if (!relative_to_file.empty()) {
+        return ResourceLoader::StripAssetNameFromPath(relative_to_file) + PATH_SEP_STR + asset_path;
+    }
+    return asset_path;
+}
+
 std::shared_ptr<SDL_Texture> TextureManager::GetTexture(const std::string & asset_path, const std::string & relative_to_file) {
     if (this->loader == nullptr) {
         LOG_ERR("TextureManager::GetTexture called before resource loader set (programming error?)");
         return nullptr;
     }
-    std::string final_path{asset_path};
-    if (!relative_to_file.empty()) {
-        final_path = ResourceLoader::StripAssetNameFromPath(relative_to_file) + PATH_SEP_STR + asset_path;
-    }
+    std::string final_path{this->GetFinalPath(asset_path, relative_to_file)};
     auto it = this->textures.find(final_path);
     if (it == this->textures.end()) {
+        // already loading in the background, so wait for that instead of loading it twice
+        auto pending_it = this->pending_textures.find(final_path);
+        if (pending_it != this->pending_textures.end()) {
+            std::shared_ptr<PendingTexture> pending = pending_it->second;
+            this->pending_textures.erase(pending_it);
+            Engine::GetInstance().jobs.Wait(pending->decoding);
+            this->ResolvePendingTexture(final_path, *pending);
+            return pending->texture;
+        }
+
         LOG_INFO("TextureManager::GetTexture attempting to load " + final_path);
         std::shared_ptr<SDL_Texture> texture_ptr = this->loader->GetImageResource(final_path);
         if (texture_ptr == nullptr) {
@@ -87,7 +101,89 @@ std::shared_ptr<SDL_Texture> TextureManager::GetTexture(const std::string & asse
     return nullptr;
 }
 
+unsigned int TextureManager::GetTextureOrdinal(const std::string & asset_path, const std::string & relative_to_file) {
+    // ordinals start at 1 and are kept across CleanUp, so a reloaded texture sorts where it did before
+    std::string final_path{this->GetFinalPath(asset_path, relative_to_file)};
+    auto it = this->texture_ordinals.find(final_path);
+    if (it == this->texture_ordinals.end()) {
+        unsigned int ordinal = static_cast<unsigned int>(this->texture_ordinals.size()) + 1;
+        it = this->texture_ordinals.insert(std::make_pair(final_path, ordinal)).first;
+    }
+    return it->second;
+}
+
+std::shared_ptr<PendingTexture> TextureManager::GetTextureAsync(const std::string & asset_path,
+                                                                const std::string & relative_to_file) {
+    std::shared_ptr<PendingTexture> pending = std::make_shared<PendingTexture>();
+    if (this->loader == nullptr) {
+        LOG_ERR("TextureManager::GetTextureAsync called before resource loader set (programming error?)");
+        pending->resolved = true;
+        return pending;
+    }
+    std::string final_path{this->GetFinalPath(asset_path, relative_to_file)};
+    auto it = this->textures.find(final_path);
+    if (it != this->textures.end()) {
+        pending->texture = it->second;
+        pending->resolved = true;
+        return pending;
+    }
+    auto pending_it = this->pending_textures.find(final_path);
+    if (pending_it != this->pending_textures.end()) {
+        return pending_it->second;
+    }
+
+    // read and decode on a worker, the upload to the renderer waits for the main thread
+    LOG_INFO("TextureManager::GetTextureAsync queueing load of " + final_path);
+    this->pending_textures.insert(std::make_pair(final_path, pending));
+    std::shared_ptr<ResourceLoader> loader = this->loader;
+    Engine::GetInstance().jobs.Schedule(
+        [loader, pending, final_path]() { pending->surface = loader->GetImageResourceAsSurface(final_path); },
+        &pending->decoding);
+    return pending;
+}
+
+void TextureManager::ResolvePendingTexture(const std::string & final_path, PendingTexture & pending) {
+    if (pending.surface != nullptr) {
+        SDL_Renderer * renderer = Engine::GetInstance().GetRenderer();
+        SDL_Texture * texture = SDL_CreateTextureFromSurface(renderer, pending.surface.get());
+        if (texture == nullptr) {
+            LOG_SDL_ERR("TextureManager::ResolvePendingTexture unable to create texture from image " + final_path);
+        } else {
+            pending.texture =
+                std::shared_ptr<SDL_Texture>{texture, [](SDL_Texture * texture) { SDLx::SDL_CleanUp(texture); }};
+        }
+        pending.surface.reset();
+    }
+    if (pending.texture == nullptr) {
+        LOG_ERR("TextureManager::ResolvePendingTexture unable to load image to texture");
+    }
+    // bad images go on the map too, to prevent infinite attempts
+    this->textures.insert(std::make_pair(final_path, pending.texture));
+    pending.resolved = true;
+}
+
 void TextureManager::SetResourceLoader(std::shared_ptr<ResourceLoader> resource_loader) {
     this->loader = std::move(resource_loader); 
 }
+
+void TextureManager::UploadPendingTextures(float budget_ms) {
+    if (this->pending_textures.empty()) {
+        return;
+    }
+
+    // always upload at least one texture per call, so a big image can't hold up everything behind it
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 budget = static_cast<Uint64>(budget_ms * SDL_GetPerformanceFrequency() / 1000.0);
+    for (auto it = this->pending_textures.begin(); it != this->pending_textures.end();) {
+        if (!it->second->decoding.IsDone()) {
+            it++;
+            continue;
+        }
+        this->ResolvePendingTexture(it->first, *it->second);
+        it = this->pending_textures.erase(it);
+        if (SDL_GetPerformanceCounter() - start >= budget) {
+            break;
+        }
+    }
+}
 }
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <cstring>
 
@@ -8,7 +10,7 @@
 namespace Critterbits {
 
 /*
- * Support functions for Tilemap::RenderMap()
+ * Support functions for Tilemap
  */
 namespace {
 void draw_object_polyline(SDL_Renderer * renderer, const Tmx::Polyline * polyline, double x, double y) {
@@ -30,6 +32,41 @@ void draw_object_polygon(SDL_Renderer * renderer, const Tmx::Polygon * polygon,
     }
 }
 
+template <typename T> CB_Rect get_point_bounds(const T * shape, double x, double y) {
+    double min_x = 0., min_y = 0., max_x = 0., max_y = 0.;
+    for (int i = 0; i < shape->GetNumPoints(); i++) {
+        double point_x = shape->GetPoint(i).x, point_y = shape->GetPoint(i).y;
+        min_x = std::min(min_x, point_x);
+        min_y = std::min(min_y, point_y);
+        max_x = std::max(max_x, point_x);
+        max_y = std::max(max_y, point_y);
+    }
+    return CB_Rect(static_cast<int>(std::floor(x + min_x)), static_cast<int>(std::floor(y + min_y)),
+                   static_cast<int>(std::ceil(max_x - min_x)) + 1, static_cast<int>(std::ceil(max_y - min_y)) + 1);
+}
+
+CB_Rect get_object_bounds(const Tmx::Object * object, int offsetx, int offsety) {
+    // polygon and polyline points are relative to the object's position, everything else uses its size
+    double x = object->GetX() + offsetx, y = object->GetY() + offsety;
+    if (object->GetPolygon() != nullptr) {
+        return get_point_bounds(object->GetPolygon(), x, y);
+    } else if (object->GetPolyline() != nullptr) {
+        return get_point_bounds(object->GetPolyline(), x, y);
+    }
+    return CB_Rect(static_cast<int>(x), static_cast<int>(y), object->GetWidth() + 1, object->GetHeight() + 1);
+}
+
+Tmx::MapTile get_object_tile(const Tmx::Object * object) {
+    // only the gid and flip flags are used, the tileset comes from the tile source table
+    return Tmx::MapTile{(unsigned int)object->GetGid(), 0, 0};
+}
+
+void get_layer_properties(const Tmx::Layer * layer, bool * is_collide, bool * is_foreground) {
+    Tmx::PropertySet properties = layer->GetProperties();
+    *is_collide = properties.GetStringProperty(CB_TILEMAP_COLLIDE) == CB_TILEMAP_TMX_PROP_BOOL_TRUE;
+    *is_foreground = properties.GetStringProperty(CB_TILEMAP_FOREGROUND) == CB_TILEMAP_TMX_PROP_BOOL_TRUE;
+}
+
 SDL_Color tmx_to_sdl_color(const std::string & tmx_color) {
     SDL_Color color{0, 0, 0, 0};
 
@@ -56,169 +93,189 @@ Tilemap::Tilemap(const std::string & map_path) : tmx_path(map_path) {
     this->draw_debug = Engine::GetInstance().config->debug.draw_map_regions;
 }
 
-Tilemap::~Tilemap() { SDLx::SDL_CleanUp(this->bg_map_texture, this->fg_map_texture); }
-
-void Tilemap::CreateCollisionRegion(const CB_Rect & dim) {
-    std::shared_ptr<TilemapRegion> region{std::make_shared<TilemapRegion>()};
-    region->dim.x = dim.x * this->render_scale;
-    region->dim.y = dim.y * this->render_scale;
-    region->dim.w = dim.w * this->render_scale;
-    region->dim.h = dim.h * this->render_scale;
-    region->collision = CollisionType::Collide;
-    region->collision_box.wh(region->dim.wh());
-    this->regions.push_back(std::move(region));
-}
-
-bool Tilemap::CreateTextures(float scale) {
-    // check to see if we already created the textures
-    if (this->bg_map_texture != nullptr && this->fg_map_texture != nullptr) {
-        return true;
-    }
-
-    // first load up the tilemap
-    std::string * tmx_data = nullptr;
-    if (Engine::GetInstance().GetResourceLoader()->GetTextResourceContents(this->tmx_path, &tmx_data) == false) {
-        LOG_ERR("Tilemap::CreateTextures unable to load TMX map " + this->tmx_path);
-        return false;
-    }
-
-    this->map.reset(new Tmx::Map());
-    map->ParseText(*tmx_data);
-    delete tmx_data;
-    if (this->map->HasError()) {
-        LOG_ERR("Tilemap::CreateTextures unable to load TMX map " + this->map->GetErrorText());
-        return false;
-    }
-    if (this->map->GetOrientation() != Tmx::TMX_MO_ORTHOGONAL) {
-        LOG_ERR("Tilemap::CreateTextures non-orthogonal maps are not supported");
-        return false;
-    }
-
-    this->tile_height = this->map->GetTileHeight() * scale;
-    this->tile_width = this->map->GetTileWidth() * scale;
-    this->dim.w = NextPowerOf2(this->map->GetWidth() * this->tile_height);
-    this->dim.h = NextPowerOf2(this->map->GetHeight() * this->tile_width);
-    this->dim.x = 0;
-    this->dim.y = 0;
-    this->render_scale = scale;
-    this->bg_color = tmx_to_sdl_color(this->map->GetBackgroundColor());
-
-    return this->RenderMap(Engine::GetInstance().GetRenderer(), scale);
-}
-
-void Tilemap::OnRender(SDL_Renderer * renderer, const CB_ViewClippingInfo & clip) {
-    SDL_Texture * texture = nullptr;
-    if (clip.z_index == ZIndex::Background && this->bg_map_texture != nullptr) {
-        texture = this->bg_map_texture;
-    } else if (clip.z_index == ZIndex::Foreground && this->fg_map_texture != nullptr) {
-        texture = this->fg_map_texture;
-    }
-    if (texture != nullptr) {
-        SDLx::SDL_RenderTextureClipped(renderer, texture, clip.source, clip.dest);
-    }
-}
-
-bool Tilemap::RenderMap(SDL_Renderer * renderer, float scale) {
-    // create texture to hold the map
-    int max_w = Engine::GetInstance().GetMaxTextureWidth();
-    int max_h = Engine::GetInstance().GetMaxTextureHeight();
-    if (max_w < this->dim.w || max_h < this->dim.h) {
-        LOG_ERR("Tilemap::RenderMap map size would result in over-sized texture (" + std::to_string(this->dim.w) + "x" +
-                std::to_string(this->dim.h) + ")");
-        return false;
-    }
-
-    SDL_Texture * fg_texture =
-        SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, this->dim.w, this->dim.h);
-    if (fg_texture == nullptr) {
-        LOG_SDL_ERR("Tilemap::RenderMap unable to create foreground texture for map");
-        return false;
+Tilemap::~Tilemap() { this->ReleaseChunks(); }
+
+bool Tilemap::BakeChunk(SDL_Renderer * renderer, size_t chunk_index) {
+    // a chunk that fails to bake is still tracked as baked (just blank), so it isn't retried every frame but goes
+    // through eviction like any other chunk and gets another try once it's evicted or released
+    MapChunk & chunk = this->chunks[chunk_index];
+    chunk.baked = true;
+    this->baked_chunks.push_back(chunk_index);
+    if (chunk.has_bg) {
+        chunk.bg_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                             chunk.dim.w, chunk.dim.h);
+        if (chunk.bg_texture == nullptr) {
+            LOG_SDL_ERR("Tilemap::BakeChunk unable to create background texture for map chunk");
+            return false;
+        }
     }
-    SDL_Texture * bg_texture =
-        SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, this->dim.w, this->dim.h);
-    if (bg_texture == nullptr) {
-        SDLx::SDL_CleanUp(fg_texture);
-        LOG_SDL_ERR("Tilemap::RenderMap unable to create background texture for map");
-        return false;
+    if (chunk.has_fg) {
+        chunk.fg_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                             chunk.dim.w, chunk.dim.h);
+        if (chunk.fg_texture == nullptr) {
+            SDLx::SDL_CleanUp(chunk.bg_texture);
+            chunk.bg_texture = nullptr;
+            LOG_SDL_ERR("Tilemap::BakeChunk unable to create foreground texture for map chunk");
+            return false;
+        }
     }
 
-    // used for creating collision regions
-    RectRegionCombiner collision_regions;
-
-    // set render target to the map texture
+    // chunks are baked in the middle of rendering the frame, so put the renderer back the way it was afterwards
+    SDL_Texture * original_target = SDL_GetRenderTarget(renderer);
     float original_scale_x, original_scale_y;
     SDL_BlendMode original_blend_mode;
+    Uint8 original_r, original_g, original_b, original_a;
     SDL_RenderGetScale(renderer, &original_scale_x, &original_scale_y);
     SDL_GetRenderDrawBlendMode(renderer, &original_blend_mode);
+    SDL_GetRenderDrawColor(renderer, &original_r, &original_g, &original_b, &original_a);
     SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
 
     // clear background texture to map background color
-    SDL_SetRenderTarget(renderer, bg_texture);
-    SDL_SetTextureBlendMode(bg_texture, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(renderer, this->bg_color.r, this->bg_color.g, this->bg_color.b, this->bg_color.a);
-    SDL_RenderClear(renderer);
+    if (chunk.bg_texture != nullptr) {
+        SDL_SetRenderTarget(renderer, chunk.bg_texture);
+        SDL_SetTextureBlendMode(chunk.bg_texture, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderDrawColor(renderer, this->bg_color.r, this->bg_color.g, this->bg_color.b, this->bg_color.a);
+        SDL_RenderClear(renderer);
+    }
 
     // clear foreground texture to transparent
-    SDL_SetRenderTarget(renderer, fg_texture);
-    SDL_SetTextureBlendMode(fg_texture, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
-    SDL_RenderClear(renderer);
+    if (chunk.fg_texture != nullptr) {
+        SDL_SetRenderTarget(renderer, chunk.fg_texture);
+        SDL_SetTextureBlendMode(chunk.fg_texture, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+    }
 
-    // iterate layers and draw
+    // iterate layers and draw the part of each that falls in this chunk
     for (auto & current_layer : this->map->GetLayers()) {
         if (current_layer->IsVisible()) {
-            // check layer properties for additional features
-            bool is_collide = false, is_foreground = false;
-            Tmx::PropertySet properties = current_layer->GetProperties();
-            if (properties.GetStringProperty(CB_TILEMAP_COLLIDE) == CB_TILEMAP_TMX_PROP_BOOL_TRUE) {
-                is_collide = true;
-            }
-            if (properties.GetStringProperty(CB_TILEMAP_FOREGROUND) == CB_TILEMAP_TMX_PROP_BOOL_TRUE) {
-                is_foreground = true;
+            bool is_collide, is_foreground;
+            get_layer_properties(current_layer, &is_collide, &is_foreground);
+            SDL_Texture * target = is_foreground ? chunk.fg_texture : chunk.bg_texture;
+            if (target == nullptr) {
+                continue;
             }
-
-            if (is_foreground) {
-                SDL_SetRenderTarget(renderer, fg_texture);
-            } else {
-                SDL_SetRenderTarget(renderer, bg_texture);
-            }
-            SDL_RenderSetScale(renderer, scale, scale);
+            SDL_SetRenderTarget(renderer, target);
+            SDL_RenderSetScale(renderer, this->render_scale, this->render_scale);
 
             switch (current_layer->GetLayerType()) {
                 case Tmx::TMX_LAYERTYPE_TILE:
-                    this->DrawMapLayer(renderer, static_cast<Tmx::TileLayer *>(current_layer),
-                                       is_collide ? &collision_regions : nullptr);
+                    this->DrawMapLayer(renderer, static_cast<Tmx::TileLayer *>(current_layer), chunk.area);
                     break;
                 case Tmx::TMX_LAYERTYPE_OBJECTGROUP:
-                    this->DrawObjectLayer(renderer, static_cast<Tmx::ObjectGroup *>(current_layer));
+                    this->DrawObjectLayer(renderer, static_cast<Tmx::ObjectGroup *>(current_layer), chunk.area.xy());
                     break;
                 case Tmx::TMX_LAYERTYPE_IMAGE_LAYER:
-                    this->DrawImageLayer(renderer, static_cast<Tmx::ImageLayer *>(current_layer));
+                    this->DrawImageLayer(renderer, static_cast<Tmx::ImageLayer *>(current_layer), chunk.area.xy());
                     break;
                 default:
-                    LOG_INFO("Tilemap::RenderMap encountered unknown layer type in TMX file");
                     break;
             }
         }
     }
 
     // reset render target
-    SDL_SetRenderTarget(renderer, NULL);
+    SDL_SetRenderTarget(renderer, original_target);
     SDL_SetRenderDrawBlendMode(renderer, original_blend_mode);
+    SDL_SetRenderDrawColor(renderer, original_r, original_g, original_b, original_a);
     SDL_RenderSetScale(renderer, original_scale_x, original_scale_y);
+    return true;
+}
 
-    // finally, create actual collision map regions
-    collision_regions.Combine();
-    for (CB_Rect & region : collision_regions.regions) {
-        this->CreateCollisionRegion(region);
+void Tilemap::BuildCollisionGrid() {
+    // bucket each collision region into every map tile it overlaps, stored as one flat list of region indices plus an
+    // offset per tile. A tile is solid if its list isn't empty, and a query only has to look at the tiles under the
+    // rect being tested, however big the map is.
+    this->collision_cell_w = this->map->GetTileWidth() * this->render_scale;
+    this->collision_cell_h = this->map->GetTileHeight() * this->render_scale;
+    int cols = this->map->GetWidth();
+    size_t cell_count = cols * this->map->GetHeight();
+    this->collision_cells.assign(cell_count + 1, 0);
+    this->collision_cell_regions.clear();
+    if (this->collision_regions.empty() || cell_count == 0) {
+        return;
     }
 
-    this->bg_map_texture = bg_texture;
-    this->fg_map_texture = fg_texture;
-    return true;
+    std::vector<CB_Rect> cell_ranges;
+    cell_ranges.reserve(this->collision_regions.size());
+    for (auto & region : this->collision_regions) {
+        cell_ranges.push_back(this->GetCollisionCellRange(region));
+        const CB_Rect & cell_range = cell_ranges.back();
+        for (int y = cell_range.y; y < cell_range.bottom(); y++) {
+            for (int x = cell_range.x; x < cell_range.right(); x++) {
+                this->collision_cells[y * cols + x + 1]++;
+            }
+        }
+    }
+    for (size_t i = 1; i <= cell_count; i++) {
+        this->collision_cells[i] += this->collision_cells[i - 1];
+    }
+
+    this->collision_cell_regions.resize(this->collision_cells[cell_count]);
+    std::vector<unsigned int> next_slot{this->collision_cells.begin(), this->collision_cells.end() - 1};
+    for (size_t i = 0; i < cell_ranges.size(); i++) {
+        const CB_Rect & cell_range = cell_ranges[i];
+        for (int y = cell_range.y; y < cell_range.bottom(); y++) {
+            for (int x = cell_range.x; x < cell_range.right(); x++) {
+                this->collision_cell_regions[next_slot[y * cols + x]++] = i;
+            }
+        }
+    }
 }
 
-void Tilemap::DrawImageLayer(SDL_Renderer * renderer, const Tmx::ImageLayer * layer) {
+void Tilemap::BuildTileSources() {
+    // one entry per gid, so finding a tile's texture and source rect doesn't have to search the tilesets or go through
+    // the texture manager for every tile
+    this->tile_sources.clear();
+    this->tileset_textures.clear();
+    this->tiles_overlap = false;
+    const std::vector<Tmx::Tileset *> & tilesets = this->map->GetTilesets();
+    for (size_t i = 0; i < tilesets.size(); i++) {
+        const Tmx::Tileset * tiles = tilesets[i];
+        const Tmx::Image * im = tiles->GetImage();
+        if (im == nullptr || tiles->GetTileWidth() <= 0 || tiles->GetTileHeight() <= 0) {
+            this->tileset_textures.push_back(nullptr);
+            continue;
+        }
+        this->tileset_textures.push_back(Engine::GetInstance().textures.GetTexture(im->GetSource(), this->tmx_path));
+        if (tiles->GetTileWidth() != this->map->GetTileWidth() ||
+            tiles->GetTileHeight() != this->map->GetTileHeight()) {
+            this->tiles_overlap = true;
+        }
+
+        // calculate tile offsets
+        int tileset_width = im->GetWidth() - (2 * tiles->GetMargin()) + tiles->GetSpacing();
+        int tileset_height = im->GetHeight() - (2 * tiles->GetMargin()) + tiles->GetSpacing();
+        int tiles_x_count = tileset_width / (tiles->GetTileWidth() + tiles->GetSpacing());
+        int tiles_y_count = tileset_height / (tiles->GetTileHeight() + tiles->GetSpacing());
+        if (tiles_x_count <= 0 || tiles_y_count <= 0) {
+            continue;
+        }
+        size_t first_gid = tiles->GetFirstGid();
+        size_t last_gid = first_gid + tiles_x_count * tiles_y_count;
+        if (this->tile_sources.size() < last_gid) {
+            this->tile_sources.resize(last_gid);
+        }
+        for (size_t gid = first_gid; gid < last_gid; gid++) {
+            int tx = (gid - first_gid) % tiles_x_count;
+            int ty = (gid - first_gid) / tiles_x_count;
+            TileSource & source = this->tile_sources[gid];
+            source.tileset_index = static_cast<int>(i);
+            source.srcrect.x = tiles->GetMargin() + (tx * tiles->GetTileWidth()) + (tx * tiles->GetSpacing());
+            source.srcrect.y = tiles->GetMargin() + (ty * tiles->GetTileHeight()) + (ty * tiles->GetSpacing());
+            source.srcrect.w = tiles->GetTileWidth();
+            source.srcrect.h = tiles->GetTileHeight();
+        }
+    }
+}
+
+void Tilemap::CreateRegions() {
+    for (size_t i = 0; i < this->regions.size(); i++) {
+        this->GetRegion(i);
+    }
+}
+
+void Tilemap::DrawImageLayer(SDL_Renderer * renderer, const Tmx::ImageLayer * layer, const CB_Point & offset) {
     SDL_Rect dim;
     const Tmx::Image * image = layer->GetImage();
     if (image == nullptr) {
@@ -229,8 +286,8 @@ void Tilemap::DrawImageLayer(SDL_Renderer * renderer, const Tmx::ImageLayer * la
         Engine::GetInstance().textures.GetTexture(image->GetSource(), this->tmx_path);
     float op = layer->GetOpacity();
 
-    dim.x = layer->GetOffsetX();
-    dim.y = layer->GetOffsetY();
+    dim.x = layer->GetOffsetX() - offset.x;
+    dim.y = layer->GetOffsetY() - offset.y;
     SDL_QueryTexture(source_image.get(), NULL, NULL, &(dim.w), &(dim.h));
 
     if (op < 1.) {
@@ -242,26 +299,53 @@ void Tilemap::DrawImageLayer(SDL_Renderer * renderer, const Tmx::ImageLayer * la
     }
 }
 
-void Tilemap::DrawMapLayer(SDL_Renderer * renderer, const Tmx::TileLayer * layer,
-                           RectRegionCombiner * collision_regions) {
+void Tilemap::DrawMapLayer(SDL_Renderer * renderer, const Tmx::TileLayer * layer, const CB_Rect & area) {
     // set layer opacity
     int alpha_mod = layer->GetOpacity() * SDL_ALPHA_OPAQUE;
 
-    // loop through tiles in map
+    // tiles are placed using their own tileset's tile size, so allow for the largest and smallest of those when
+    // working out which tiles can reach into the area
+    int offsetx = layer->GetOffsetX();
+    int offsety = layer->GetOffsetY();
+    int first_col = std::max((area.x - offsetx) / this->max_tileset_tile.x - 1, 0);
+    int last_col = std::min((area.right() - offsetx) / this->min_tileset_tile.x + 1, this->map->GetWidth() - 1);
+    int first_row = std::max((area.y - offsety) / this->max_tileset_tile.y - 1, 0);
+    int last_row = std::min((area.bottom() - offsety) / this->min_tileset_tile.y + 1, this->map->GetHeight() - 1);
+    if (first_col > last_col || first_row > last_row) {
+        return;
+    }
+
+    // tiles on a layer only overlap when a tileset's tiles differ in size from the map's, otherwise they can be
+    // grouped by tileset so each texture's alpha is set once and its copies reach the renderer back to back
+    size_t group_count = this->tiles_overlap ? 1 : std::max<size_t>(this->tileset_textures.size(), 1);
+    if (this->tile_draw_groups.size() < group_count) {
+        this->tile_draw_groups.resize(group_count);
+    }
     struct MapTileInfo tile_info;
-    tile_info.offsetx = layer->GetOffsetX();
-    tile_info.offsety = layer->GetOffsetY();
-    tile_info.alpha_mod = alpha_mod;
-    for (int i = 0; i < this->map->GetHeight(); i++) {
-        for (int j = 0; j < this->map->GetWidth(); j++) {
+    tile_info.offsetx = offsetx;
+    tile_info.offsety = offsety;
+    tile_info.alpha_mod = SDL_ALPHA_OPAQUE;
+    MapTileDraw tile_draw;
+    for (int i = first_row; i <= last_row; i++) {
+        for (int j = first_col; j <= last_col; j++) {
             tile_info.row = i;
             tile_info.col = j;
-            this->DrawTileOnMap(renderer, layer->GetTile(j, i), tile_info, collision_regions);
+            if (this->GetTileDraw(layer->GetTile(j, i), tile_info, &tile_draw)) {
+                this->tile_draw_groups[this->tiles_overlap ? 0 : tile_draw.tileset_index].push_back(tile_draw);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < group_count; i++) {
+        if (!this->tile_draw_groups[i].empty()) {
+            this->DrawTiles(renderer, this->tile_draw_groups[i], alpha_mod, area.xy());
+            this->tile_draw_groups[i].clear();
         }
     }
 }
 
-void Tilemap::DrawObjectLayer(SDL_Renderer * renderer, const Tmx::ObjectGroup * object_group) {
+void Tilemap::DrawObjectLayer(SDL_Renderer * renderer, const Tmx::ObjectGroup * object_group,
+                              const CB_Point & offset) {
     SDL_Rect rect;
     SDL_Color obj_color;
     if (object_group->GetColor().empty()) {
@@ -276,34 +360,35 @@ void Tilemap::DrawObjectLayer(SDL_Renderer * renderer, const Tmx::ObjectGroup *
     tile_info.offsety = object_group->GetOffsetY();
     tile_info.alpha_mod = object_group->GetOpacity() * SDL_ALPHA_OPAQUE;
 
+    // debug shapes are drawn directly, so they need moving into the chunk themselves
+    int shape_offsetx = tile_info.offsetx - offset.x;
+    int shape_offsety = tile_info.offsety - offset.y;
+
     for (auto & current_obj : object_group->GetObjects()) {
         if (current_obj->IsVisible()) {
             if (current_obj->GetGid() > 0) {
                 tile_info.col = current_obj->GetX() * -1;
                 tile_info.row = current_obj->GetY() * -1;
-                Tmx::MapTile tile{(unsigned int)current_obj->GetGid(),
-                                  this->map->FindTileset((unsigned int)current_obj->GetGid())->GetFirstGid(),
-                                  (unsigned int)this->map->FindTilesetIndex((unsigned int)current_obj->GetGid())};
-                this->DrawTileOnMap(renderer, tile, tile_info);
+                this->DrawTileOnMap(renderer, get_object_tile(current_obj), tile_info, offset);
             } else if (this->draw_debug) {
                 // region objects are normally hidden and used as event triggers
                 if (current_obj->GetPolygon() != nullptr) {
                     SDL_SetRenderDrawColor(renderer, obj_color.r, obj_color.g, obj_color.b, obj_color.a);
-                    draw_object_polygon(renderer, current_obj->GetPolygon(), current_obj->GetX() + tile_info.offsetx,
-                                        current_obj->GetY() + tile_info.offsety);
+                    draw_object_polygon(renderer, current_obj->GetPolygon(), current_obj->GetX() + shape_offsetx,
+                                        current_obj->GetY() + shape_offsety);
                 } else if (current_obj->GetPolyline() != nullptr) {
                     SDL_SetRenderDrawColor(renderer, obj_color.r, obj_color.g, obj_color.b, obj_color.a);
-                    draw_object_polyline(renderer, current_obj->GetPolyline(), current_obj->GetX() + tile_info.offsetx,
-                                         current_obj->GetY() + tile_info.offsety);
+                    draw_object_polyline(renderer, current_obj->GetPolyline(), current_obj->GetX() + shape_offsetx,
+                                         current_obj->GetY() + shape_offsety);
                 } else if (current_obj->GetEllipse() != nullptr) {
                     int radius_x = current_obj->GetWidth() / 2, radius_y = current_obj->GetHeight() / 2;
-                    int center_x = current_obj->GetX() + tile_info.offsetx + radius_x,
-                        center_y = current_obj->GetY() + tile_info.offsety + radius_y;
+                    int center_x = current_obj->GetX() + shape_offsetx + radius_x,
+                        center_y = current_obj->GetY() + shape_offsety + radius_y;
                     ellipseRGBA(renderer, center_x, center_y, radius_x, radius_y, obj_color.r, obj_color.g, obj_color.b,
                                 obj_color.a);
                 } else {
-                    rect.x = current_obj->GetX() + tile_info.offsetx;
-                    rect.y = current_obj->GetY() + tile_info.offsety;
+                    rect.x = current_obj->GetX() + shape_offsetx;
+                    rect.y = current_obj->GetY() + shape_offsety;
                     rect.w = current_obj->GetWidth();
                     rect.h = current_obj->GetHeight();
                     SDL_SetRenderDrawColor(renderer, obj_color.r, obj_color.g, obj_color.b, obj_color.a);
@@ -315,65 +400,454 @@ void Tilemap::DrawObjectLayer(SDL_Renderer * renderer, const Tmx::ObjectGroup *
 }
 
 void Tilemap::DrawTileOnMap(SDL_Renderer * renderer, const Tmx::MapTile & tile, const MapTileInfo & tile_info,
-                            RectRegionCombiner * collision_regions) {
-    CB_Rect srcrect, dstrect;
+                            const CB_Point & offset) {
+    std::vector<MapTileDraw> tile_draws(1);
+    if (this->GetTileDraw(tile, tile_info, &tile_draws[0])) {
+        this->DrawTiles(renderer, tile_draws, tile_info.alpha_mod, offset);
+    }
+}
 
-    // if we have a tile at this position, draw it
-    const Tmx::Tileset * tiles = this->map->FindTileset(tile.gid);
-    if (tiles != nullptr) {
-        // get image and calculate tile offsets
-        const Tmx::Image * im = tiles->GetImage();
-        if (im == nullptr) {
-            return;
-        }
-        int tileset_width = im->GetWidth() - (2 * tiles->GetMargin()) + tiles->GetSpacing();
-        int tiles_x_count = tileset_width / (tiles->GetTileWidth() + tiles->GetSpacing());
-        int tx = tile.id % tiles_x_count;
-        int ty = tile.id / tiles_x_count;
-
-        // source dimensions and position
-        srcrect.x = tiles->GetMargin() + (tx * tiles->GetTileWidth()) + (tx * tiles->GetSpacing());
-        srcrect.y = tiles->GetMargin() + (ty * tiles->GetTileHeight()) + (ty * tiles->GetSpacing());
-        srcrect.w = tiles->GetTileWidth();
-        srcrect.h = tiles->GetTileHeight();
-
-        // destination dimensions and position
-        dstrect.w = tiles->GetTileWidth();
-        dstrect.h = tiles->GetTileHeight();
-        // FIXME: this is a hack hack hack
-        if (tile_info.row < 0) {
-            dstrect.x = tile_info.col * -1 + tile_info.offsetx;
-            dstrect.y = tile_info.row * -1 + tile_info.offsety;
-        } else {
-            dstrect.x = tile_info.col * tiles->GetTileWidth() + tile_info.offsetx;
-            dstrect.y = tile_info.row * tiles->GetTileHeight() + tile_info.offsety;
+void Tilemap::DrawTiles(SDL_Renderer * renderer, const std::vector<MapTileDraw> & tile_draws, int alpha_mod,
+                        const CB_Point & offset) {
+    int current_tileset = -1;
+    SDL_Texture * tileset_image = nullptr;
+    CB_Rect dstrect;
+    for (auto & tile_draw : tile_draws) {
+        // select source image, grouped draws only switch once
+        if (tile_draw.tileset_index != current_tileset) {
+            if (tileset_image != nullptr && alpha_mod < SDL_ALPHA_OPAQUE) {
+                SDL_SetTextureAlphaMod(tileset_image, SDL_ALPHA_OPAQUE);
+            }
+            current_tileset = tile_draw.tileset_index;
+            tileset_image = this->tileset_textures[current_tileset].get();
+
+            // set alpha modulation based on layer opacity
+            if (tileset_image != nullptr && alpha_mod < SDL_ALPHA_OPAQUE) {
+                SDL_SetTextureAlphaMod(tileset_image, alpha_mod);
+            }
         }
 
-        // select source image
-        std::shared_ptr<SDL_Texture> tileset_image =
-            Engine::GetInstance().textures.GetTexture(im->GetSource(), this->tmx_path);
+        // render tile, relative to the chunk being baked
         if (tileset_image != nullptr) {
+            dstrect = tile_draw.dstrect;
+            dstrect.x -= offset.x;
+            dstrect.y -= offset.y;
+            SDLx::SDL_RenderTextureClipped(renderer, tileset_image, tile_draw.srcrect, dstrect, tile_draw.flip_x,
+                                           tile_draw.flip_y, tile_draw.rotate);
+        }
+    }
 
-            // set alpha modulation based on layer opacity
-            if (tile_info.alpha_mod < SDL_ALPHA_OPAQUE) {
-                SDL_SetTextureAlphaMod(tileset_image.get(), tile_info.alpha_mod);
+    // reset alpha modulation
+    if (tileset_image != nullptr && alpha_mod < SDL_ALPHA_OPAQUE) {
+        SDL_SetTextureAlphaMod(tileset_image, SDL_ALPHA_OPAQUE);
+    }
+}
+
+void Tilemap::EvictChunks(size_t keep) {
+    // release the least recently drawn chunks, but never ones drawn in this frame's passes
+    while (this->baked_chunks.size() > keep) {
+        size_t oldest = this->baked_chunks.size();
+        for (size_t i = 0; i < this->baked_chunks.size(); i++) {
+            const MapChunk & chunk = this->chunks[this->baked_chunks[i]];
+            if (chunk.last_used + 1 < this->render_stamp &&
+                (oldest == this->baked_chunks.size() ||
+                 chunk.last_used < this->chunks[this->baked_chunks[oldest]].last_used)) {
+                oldest = i;
+            }
+        }
+        if (oldest == this->baked_chunks.size()) {
+            break;
+        }
+        MapChunk & chunk = this->chunks[this->baked_chunks[oldest]];
+        SDLx::SDL_CleanUp(chunk.bg_texture, chunk.fg_texture);
+        chunk.bg_texture = nullptr;
+        chunk.fg_texture = nullptr;
+        chunk.baked = false;
+        this->baked_chunks[oldest] = this->baked_chunks.back();
+        this->baked_chunks.pop_back();
+    }
+}
+
+CB_Rect Tilemap::GetCollisionCellRange(const CB_Rect & rect) const {
+    // like ColliderGrid the right/bottom edge is inclusive, and anything off the map is clamped to the edge tiles
+    int max_x = this->map->GetWidth() - 1;
+    int max_y = this->map->GetHeight() - 1;
+    int x1 = std::min(std::max(static_cast<int>(std::floor(rect.x / this->collision_cell_w)), 0), max_x);
+    int y1 = std::min(std::max(static_cast<int>(std::floor(rect.y / this->collision_cell_h)), 0), max_y);
+    int x2 = std::min(std::max(static_cast<int>(std::floor(rect.right() / this->collision_cell_w)), 0), max_x);
+    int y2 = std::min(std::max(static_cast<int>(std::floor(rect.bottom() / this->collision_cell_h)), 0), max_y);
+    return CB_Rect{x1, y1, x2 - x1 + 1, y2 - y1 + 1};
+}
+
+TilemapRegion * Tilemap::GetRegion(size_t region_index) {
+    // regions only become entities once something needs to see them, i.e. the debug overlay or a collision event
+    std::shared_ptr<TilemapRegion> & region = this->regions[region_index];
+    if (region == nullptr) {
+        region = std::make_shared<TilemapRegion>();
+        region->dim = this->collision_regions[region_index];
+        region->collision = CollisionType::Collide;
+        region->collision_box.wh(region->dim.wh());
+        region->Start();
+        Engine::GetInstance().entities.Register(region);
+        this->region_entity_count++;
+    }
+    return region.get();
+}
+
+bool Tilemap::GetTileDraw(const Tmx::MapTile & tile, const MapTileInfo & tile_info, MapTileDraw * tile_draw) const {
+    // if we have a tile at this position, work out where to draw it from and to
+    if (tile.gid >= this->tile_sources.size() || this->tile_sources[tile.gid].tileset_index < 0) {
+        return false;
+    }
+    const TileSource & source = this->tile_sources[tile.gid];
+    tile_draw->tileset_index = source.tileset_index;
+    tile_draw->srcrect = source.srcrect;
+
+    // destination dimensions and position
+    tile_draw->dstrect.w = source.srcrect.w;
+    tile_draw->dstrect.h = source.srcrect.h;
+    // FIXME: this is a hack hack hack
+    if (tile_info.row < 0) {
+        tile_draw->dstrect.x = tile_info.col * -1 + tile_info.offsetx;
+        tile_draw->dstrect.y = tile_info.row * -1 + tile_info.offsety;
+    } else {
+        tile_draw->dstrect.x = tile_info.col * source.srcrect.w + tile_info.offsetx;
+        tile_draw->dstrect.y = tile_info.row * source.srcrect.h + tile_info.offsety;
+    }
+
+    tile_draw->flip_x = tile.flippedHorizontally;
+    tile_draw->flip_y = tile.flippedVertically;
+    tile_draw->rotate = tile.flippedDiagonally ? -90. : 0.;
+    return true;
+}
+
+void Tilemap::IndexImageLayer(const Tmx::ImageLayer * layer, bool is_foreground) {
+    const Tmx::Image * image = layer->GetImage();
+    if (image == nullptr) {
+        return;
+    }
+    std::shared_ptr<SDL_Texture> source_image =
+        Engine::GetInstance().textures.GetTexture(image->GetSource(), this->tmx_path);
+    CB_Rect dim{layer->GetOffsetX(), layer->GetOffsetY(), 0, 0};
+    SDL_QueryTexture(source_image.get(), NULL, NULL, &(dim.w), &(dim.h));
+    this->MarkChunks(dim, is_foreground);
+}
+
+void Tilemap::IndexMap() {
+    // chunks are a whole number of tiles, as close to CB_TILEMAP_CHUNK_SIZE scaled pixels across as possible
+    int map_tile_w = this->map->GetTileWidth();
+    int map_tile_h = this->map->GetTileHeight();
+    this->chunk_map_size.x = std::max(static_cast<int>(CB_TILEMAP_CHUNK_SIZE / (map_tile_w * this->render_scale)), 1) *
+                             map_tile_w;
+    this->chunk_map_size.y = std::max(static_cast<int>(CB_TILEMAP_CHUNK_SIZE / (map_tile_h * this->render_scale)), 1) *
+                             map_tile_h;
+    int map_w = this->map->GetWidth() * map_tile_w;
+    int map_h = this->map->GetHeight() * map_tile_h;
+    this->chunk_cols = (map_w + this->chunk_map_size.x - 1) / this->chunk_map_size.x;
+    this->chunk_rows = (map_h + this->chunk_map_size.y - 1) / this->chunk_map_size.y;
+    this->chunks.assign(this->chunk_cols * this->chunk_rows, MapChunk{});
+    for (int cy = 0; cy < this->chunk_rows; cy++) {
+        for (int cx = 0; cx < this->chunk_cols; cx++) {
+            MapChunk & chunk = this->chunks[cy * this->chunk_cols + cx];
+            chunk.area.x = cx * this->chunk_map_size.x;
+            chunk.area.y = cy * this->chunk_map_size.y;
+            chunk.area.w = std::min(this->chunk_map_size.x, map_w - chunk.area.x);
+            chunk.area.h = std::min(this->chunk_map_size.y, map_h - chunk.area.y);
+            chunk.dim.x = static_cast<int>(chunk.area.x * this->render_scale);
+            chunk.dim.y = static_cast<int>(chunk.area.y * this->render_scale);
+            chunk.dim.w = static_cast<int>(chunk.area.right() * this->render_scale) - chunk.dim.x;
+            chunk.dim.h = static_cast<int>(chunk.area.bottom() * this->render_scale) - chunk.dim.y;
+        }
+    }
+
+    // range of tileset tile sizes, tiles are placed by these rather than the map's tile size
+    this->min_tileset_tile = CB_Point{map_tile_w, map_tile_h};
+    this->max_tileset_tile = CB_Point{map_tile_w, map_tile_h};
+    for (auto & tileset : this->map->GetTilesets()) {
+        if (tileset->GetTileWidth() > 0 && tileset->GetTileHeight() > 0) {
+            this->min_tileset_tile.x = std::min(this->min_tileset_tile.x, tileset->GetTileWidth());
+            this->min_tileset_tile.y = std::min(this->min_tileset_tile.y, tileset->GetTileHeight());
+            this->max_tileset_tile.x = std::max(this->max_tileset_tile.x, tileset->GetTileWidth());
+            this->max_tileset_tile.y = std::max(this->max_tileset_tile.y, tileset->GetTileHeight());
+        }
+    }
+
+    // used for creating collision regions
+    RectRegionCombiner region_combiner;
+
+    // work out which chunks each layer draws on, and where the collision tiles are
+    for (auto & current_layer : this->map->GetLayers()) {
+        if (current_layer->IsVisible()) {
+            bool is_collide, is_foreground;
+            get_layer_properties(current_layer, &is_collide, &is_foreground);
+            switch (current_layer->GetLayerType()) {
+                case Tmx::TMX_LAYERTYPE_TILE:
+                    this->IndexMapLayer(static_cast<Tmx::TileLayer *>(current_layer), is_foreground,
+                                        is_collide ? &region_combiner : nullptr);
+                    break;
+                case Tmx::TMX_LAYERTYPE_OBJECTGROUP:
+                    this->IndexObjectLayer(static_cast<Tmx::ObjectGroup *>(current_layer), is_foreground);
+                    break;
+                case Tmx::TMX_LAYERTYPE_IMAGE_LAYER:
+                    this->IndexImageLayer(static_cast<Tmx::ImageLayer *>(current_layer), is_foreground);
+                    break;
+                default:
+                    LOG_INFO("Tilemap::IndexMap encountered unknown layer type in TMX file");
+                    break;
+            }
+        }
+    }
+
+    // a background color shows through everywhere, even where no layer draws
+    if (this->bg_color.a > 0) {
+        for (auto & chunk : this->chunks) {
+            chunk.has_bg = true;
+        }
+        this->render_layers |= ZIndexMask(ZIndex::Background);
+    }
+
+    // finally, create actual collision map regions (entities for them are created on demand)
+    region_combiner.Combine();
+    this->collision_regions.clear();
+    this->collision_regions.reserve(region_combiner.regions.size());
+    for (CB_Rect & region : region_combiner.regions) {
+        this->collision_regions.emplace_back(
+            static_cast<int>(region.x * this->render_scale), static_cast<int>(region.y * this->render_scale),
+            static_cast<int>(region.w * this->render_scale), static_cast<int>(region.h * this->render_scale));
+    }
+    this->regions.assign(this->collision_regions.size(), nullptr);
+    this->BuildCollisionGrid();
+
+    size_t used_chunks = std::count_if(this->chunks.begin(), this->chunks.end(),
+                                       [](const MapChunk & chunk) { return chunk.has_bg || chunk.has_fg; });
+    LOG_INFO("Tilemap::IndexMap " + this->tmx_path + " has " + std::to_string(used_chunks) + " of " +
+             std::to_string(this->chunks.size()) + " chunks in use");
+}
+
+void Tilemap::IndexMapLayer(const Tmx::TileLayer * layer, bool is_foreground,
+                            RectRegionCombiner * region_combiner) {
+    // work out where each tile is drawn first (this only reads the parsed map, so rows can be done on the job
+    // system), then mark chunks and collect collision tiles on this thread
+    int map_width = this->map->GetWidth();
+    std::vector<MapTileDraw> tile_draws(map_width * this->map->GetHeight());
+    auto get_rows = [this, layer, map_width, &tile_draws](size_t begin, size_t end) {
+        struct MapTileInfo tile_info;
+        tile_info.offsetx = layer->GetOffsetX();
+        tile_info.offsety = layer->GetOffsetY();
+        tile_info.alpha_mod = SDL_ALPHA_OPAQUE;
+        for (size_t i = begin; i < end; i++) {
+            for (int j = 0; j < map_width; j++) {
+                tile_info.row = i;
+                tile_info.col = j;
+                MapTileDraw & tile_draw = tile_draws[i * map_width + j];
+                if (!this->GetTileDraw(layer->GetTile(j, i), tile_info, &tile_draw)) {
+                    tile_draw.tileset_index = -1;
+                }
+            }
+        }
+    };
+    if (Engine::GetInstance().config->threading.parallel_tilemap) {
+        Engine::GetInstance().jobs.ParallelFor(this->map->GetHeight(), CB_JOBS_TILEMAP_GRAIN, get_rows);
+    } else {
+        get_rows(0, this->map->GetHeight());
+    }
+
+    for (auto & tile_draw : tile_draws) {
+        if (tile_draw.tileset_index >= 0) {
+            this->MarkChunks(tile_draw.dstrect, is_foreground);
+            if (region_combiner != nullptr) {
+                region_combiner->regions.push_back(tile_draw.dstrect);
+            }
+        }
+    }
+}
+
+void Tilemap::IndexObjectLayer(const Tmx::ObjectGroup * object_group, bool is_foreground) {
+    struct MapTileInfo tile_info;
+    tile_info.offsetx = object_group->GetOffsetX();
+    tile_info.offsety = object_group->GetOffsetY();
+    tile_info.alpha_mod = SDL_ALPHA_OPAQUE;
+    MapTileDraw tile_draw;
+    for (auto & current_obj : object_group->GetObjects()) {
+        if (current_obj->IsVisible()) {
+            if (current_obj->GetGid() > 0) {
+                tile_info.col = current_obj->GetX() * -1;
+                tile_info.row = current_obj->GetY() * -1;
+                if (this->GetTileDraw(get_object_tile(current_obj), tile_info, &tile_draw)) {
+                    this->MarkChunks(tile_draw.dstrect, is_foreground);
+                }
+            } else if (this->draw_debug) {
+                this->MarkChunks(get_object_bounds(current_obj, tile_info.offsetx, tile_info.offsety), is_foreground);
+            }
+        }
+    }
+}
+
+bool Tilemap::LoadMap(float scale) {
+    // check to see if we already loaded the map
+    if (this->map != nullptr) {
+        return true;
+    }
+
+    // first load up the tilemap
+    std::string * tmx_data = nullptr;
+    if (Engine::GetInstance().GetResourceLoader()->GetTextResourceContents(this->tmx_path, &tmx_data) == false) {
+        LOG_ERR("Tilemap::LoadMap unable to load TMX map " + this->tmx_path);
+        return false;
+    }
+
+    std::unique_ptr<Tmx::Map> tmx_map{new Tmx::Map()};
+    tmx_map->ParseText(*tmx_data);
+    delete tmx_data;
+    if (tmx_map->HasError()) {
+        LOG_ERR("Tilemap::LoadMap unable to load TMX map " + tmx_map->GetErrorText());
+        return false;
+    }
+    if (tmx_map->GetOrientation() != Tmx::TMX_MO_ORTHOGONAL) {
+        LOG_ERR("Tilemap::LoadMap non-orthogonal maps are not supported");
+        return false;
+    }
+    this->map = std::move(tmx_map);
+
+    this->tile_height = this->map->GetTileHeight() * scale;
+    this->tile_width = this->map->GetTileWidth() * scale;
+    this->dim.w = static_cast<int>(this->map->GetWidth() * this->map->GetTileWidth() * scale);
+    this->dim.h = static_cast<int>(this->map->GetHeight() * this->map->GetTileHeight() * scale);
+    this->dim.x = 0;
+    this->dim.y = 0;
+    this->render_scale = scale;
+    this->bg_color = tmx_to_sdl_color(this->map->GetBackgroundColor());
+
+    // nothing is drawn yet, chunks are baked as they come into view
+    this->BuildTileSources();
+    this->IndexMap();
+
+    // the region debug overlay draws every region, so they're all needed as entities up front
+    if (this->draw_debug) {
+        this->CreateRegions();
+    }
+    return true;
+}
+
+void Tilemap::MarkChunks(const CB_Rect & rect, bool is_foreground) {
+    // anything outside the map was never visible
+    int map_w = this->map->GetWidth() * this->map->GetTileWidth();
+    int map_h = this->map->GetHeight() * this->map->GetTileHeight();
+    int x1 = std::max(rect.x, 0);
+    int y1 = std::max(rect.y, 0);
+    int x2 = std::min(rect.right(), map_w);
+    int y2 = std::min(rect.bottom(), map_h);
+    if (x2 <= x1 || y2 <= y1) {
+        return;
+    }
+    for (int cy = y1 / this->chunk_map_size.y; cy <= (y2 - 1) / this->chunk_map_size.y; cy++) {
+        for (int cx = x1 / this->chunk_map_size.x; cx <= (x2 - 1) / this->chunk_map_size.x; cx++) {
+            MapChunk & chunk = this->chunks[cy * this->chunk_cols + cx];
+            if (is_foreground) {
+                chunk.has_fg = true;
+            } else {
+                chunk.has_bg = true;
             }
+        }
+    }
+    this->render_layers |= ZIndexMask(is_foreground ? ZIndex::Foreground : ZIndex::Background);
+}
 
-            // render tile
-            double rotate = tile.flippedDiagonally ? -90. : 0.;
-            SDLx::SDL_RenderTextureClipped(renderer, tileset_image.get(), srcrect, dstrect, tile.flippedHorizontally,
-                                           tile.flippedVertically, rotate);
+void Tilemap::OnRender(SDL_Renderer * renderer, const CB_ViewClippingInfo & clip) {
+    bool is_foreground = clip.z_index == ZIndex::Foreground;
+    if (this->chunks.empty() || (!is_foreground && clip.z_index != ZIndex::Background)) {
+        return;
+    }
+    this->render_stamp++;
+
+    // chunks under the visible part of the map (source is relative to the map, in scaled pixels)
+    float chunk_w = this->chunk_map_size.x * this->render_scale;
+    float chunk_h = this->chunk_map_size.y * this->render_scale;
+    int first_col = std::max(static_cast<int>(clip.source.x / chunk_w), 0);
+    int last_col = std::min(static_cast<int>((clip.source.right() - 1) / chunk_w), this->chunk_cols - 1);
+    int first_row = std::max(static_cast<int>(clip.source.y / chunk_h), 0);
+    int last_row = std::min(static_cast<int>((clip.source.bottom() - 1) / chunk_h), this->chunk_rows - 1);
+    size_t visible_chunks = 0;
+    for (int cy = first_row; cy <= last_row; cy++) {
+        for (int cx = first_col; cx <= last_col; cx++) {
+            size_t chunk_index = cy * this->chunk_cols + cx;
+            MapChunk & chunk = this->chunks[chunk_index];
+            if (!chunk.has_bg && !chunk.has_fg) {
+                continue;
+            }
+            if (!chunk.baked) {
+                this->BakeChunk(renderer, chunk_index);
+            }
+            chunk.last_used = this->render_stamp;
+            visible_chunks++;
 
-            // reset alpha modulation
-            if (tile_info.alpha_mod < SDL_ALPHA_OPAQUE) {
-                SDL_SetTextureAlphaMod(tileset_image.get(), SDL_ALPHA_OPAQUE);
+            SDL_Texture * texture = is_foreground ? chunk.fg_texture : chunk.bg_texture;
+            if (texture == nullptr) {
+                continue;
             }
+
+            // part of the chunk that's in view, and where that lands in the window
+            int x1 = std::max(clip.source.x, chunk.dim.x);
+            int y1 = std::max(clip.source.y, chunk.dim.y);
+            int x2 = std::min(clip.source.right(), chunk.dim.right());
+            int y2 = std::min(clip.source.bottom(), chunk.dim.bottom());
+            if (x2 <= x1 || y2 <= y1) {
+                continue;
+            }
+            CB_Rect source{x1 - chunk.dim.x, y1 - chunk.dim.y, x2 - x1, y2 - y1};
+            CB_Rect dest{clip.dest.x + x1 - clip.source.x, clip.dest.y + y1 - clip.source.y, x2 - x1, y2 - y1};
+            SDLx::SDL_RenderTextureClipped(renderer, texture, source, dest);
         }
+    }
 
-        // create collision region if needed
-        if (collision_regions != nullptr) {
-            collision_regions->regions.push_back(dstrect);
+    // on the first pass of the frame, bake a few of the chunks bordering the view so scrolling onto them doesn't
+    // stall, then let go of whatever hasn't been drawn for the longest
+    if (is_foreground && TestBitMask<unsigned int>(this->render_layers, ZIndexMask(ZIndex::Background))) {
+        return;
+    }
+    int prefetched = 0;
+    for (int cy = std::max(first_row - 1, 0); cy <= std::min(last_row + 1, this->chunk_rows - 1); cy++) {
+        for (int cx = std::max(first_col - 1, 0); cx <= std::min(last_col + 1, this->chunk_cols - 1); cx++) {
+            MapChunk & chunk = this->chunks[cy * this->chunk_cols + cx];
+            if (prefetched < CB_TILEMAP_CHUNK_PREFETCH && !chunk.baked && (chunk.has_bg || chunk.has_fg)) {
+                this->BakeChunk(renderer, cy * this->chunk_cols + cx);
+                chunk.last_used = this->render_stamp;
+                prefetched++;
+            }
         }
     }
+    this->EvictChunks(std::max<size_t>(CB_TILEMAP_CHUNK_CACHE_SIZE, visible_chunks + CB_TILEMAP_CHUNK_PREFETCH));
+}
+
+void Tilemap::QueryCollisionRegions(const CB_Rect & rect, std::vector<size_t> * region_indexes) const {
+    if (this->collision_regions.empty()) {
+        return;
+    }
+    CB_Rect cell_range = this->GetCollisionCellRange(rect);
+    int cols = this->map->GetWidth();
+    size_t first = region_indexes->size();
+    for (int y = cell_range.y; y < cell_range.bottom(); y++) {
+        for (int x = cell_range.x; x < cell_range.right(); x++) {
+            size_t cell = y * cols + x;
+            region_indexes->insert(region_indexes->end(),
+                                   this->collision_cell_regions.begin() + this->collision_cells[cell],
+                                   this->collision_cell_regions.begin() + this->collision_cells[cell + 1]);
+        }
+    }
+
+    // regions spanning several tiles show up more than once
+    std::sort(region_indexes->begin() + first, region_indexes->end());
+    region_indexes->erase(std::unique(region_indexes->begin() + first, region_indexes->end()), region_indexes->end());
+}
+
+void Tilemap::ReleaseChunks() {
+    for (size_t chunk_index : this->baked_chunks) {
+        MapChunk & chunk = this->chunks[chunk_index];
+        SDLx::SDL_CleanUp(chunk.bg_texture, chunk.fg_texture);
+        chunk.bg_texture = nullptr;
+        chunk.fg_texture = nullptr;
+        chunk.baked = false;
+    }
+    this->baked_chunks.clear();
 }
 }
\ No newline at end of file
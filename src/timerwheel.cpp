@@ -0,0 +1,98 @@
+#include <cb/critterbits.hpp>
+
+namespace Critterbits {
+namespace {
+const unsigned int slot_count = 1 << CB_TIMER_WHEEL_BITS;
+const unsigned int slot_mask = slot_count - 1;
+}
+
+TimerWheel::TimerWheel() { this->slots.resize(slot_count * CB_TIMER_WHEEL_LEVELS); }
+
+void TimerWheel::Advance(float delta_ms) {
+    this->partial_ms += delta_ms;
+    while (this->partial_ms >= 1.f) {
+        this->partial_ms -= 1.f;
+        this->Tick();
+    }
+}
+
+bool TimerWheel::Cancel(timer_id_t timer_id) {
+    // the wheel entry stays behind and is skipped once its slot comes up
+    return this->timers.erase(timer_id) > 0;
+}
+
+int TimerWheel::Cascade(int level) {
+    int index = static_cast<int>((this->now >> (CB_TIMER_WHEEL_BITS * level)) & slot_mask);
+    std::vector<TimerEntry> entries;
+    entries.swap(this->slots[level * slot_count + index]);
+    for (auto & entry : entries) {
+        auto timer = this->timers.find(entry.timer_id);
+        if (timer != this->timers.end() && timer->second.generation == entry.generation) {
+            this->Insert(entry);
+        }
+    }
+    return index;
+}
+
+void TimerWheel::Insert(const TimerEntry & entry) {
+    tick_t delta = entry.expires > this->now ? entry.expires - this->now : 0;
+    tick_t expires = entry.expires > this->now ? entry.expires : this->now;
+    int level = 0;
+    while (level < CB_TIMER_WHEEL_LEVELS - 1 &&
+           delta >= (static_cast<tick_t>(1) << (CB_TIMER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    if (delta >= (static_cast<tick_t>(1) << (CB_TIMER_WHEEL_BITS * CB_TIMER_WHEEL_LEVELS))) {
+        // beyond the last level, park it as far out as the wheel reaches and let it cascade back up
+        expires = this->now + (static_cast<tick_t>(1) << (CB_TIMER_WHEEL_BITS * CB_TIMER_WHEEL_LEVELS)) - 1;
+    }
+    unsigned int index = static_cast<unsigned int>((expires >> (CB_TIMER_WHEEL_BITS * level)) & slot_mask);
+    this->slots[level * slot_count + index].push_back(entry);
+}
+
+void TimerWheel::Schedule(timer_id_t timer_id, unsigned int delay_ms, TimerFunction func) {
+    // scheduling an ID that is already pending replaces it
+    unsigned long generation = this->next_generation++;
+    this->timers[timer_id] = Timer{std::move(func), generation};
+
+    // a delay of zero fires on the next tick
+    this->Insert(TimerEntry{timer_id, this->now + (delay_ms > 0 ? delay_ms : 1), generation});
+}
+
+void TimerWheel::Tick() {
+    this->now++;
+    int index = static_cast<int>(this->now & slot_mask);
+
+    // every time a level wraps around, the next level's current slot is redistributed into the levels below
+    if (index == 0) {
+        for (int level = 1; level < CB_TIMER_WHEEL_LEVELS; level++) {
+            if (this->Cascade(level) != 0) {
+                break;
+            }
+        }
+    }
+
+    std::vector<TimerEntry> & slot = this->slots[index];
+    if (slot.empty()) {
+        return;
+    }
+    std::vector<TimerEntry> due;
+    due.swap(slot);
+    for (auto & entry : due) {
+        auto timer = this->timers.find(entry.timer_id);
+        if (timer == this->timers.end() || timer->second.generation != entry.generation) {
+            continue;
+        }
+        // remove the timer before calling it, so it can schedule itself again
+        TimerFunction func = std::move(timer->second.func);
+        this->timers.erase(timer);
+        func();
+    }
+
+    // hand the storage back so a busy slot doesn't reallocate every lap
+    if (this->slots[index].empty()) {
+        due.clear();
+        this->slots[index].swap(due);
+    }
+}
+}
\ No newline at end of file
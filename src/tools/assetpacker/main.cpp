@@ -16,6 +16,7 @@
 
 #include <cb/assetpack.hpp>
 #include <cb/toml.hpp>
+#include <duktape/duktape.h>
 #include <zstd.h>
 
 #ifdef _WIN32
@@ -32,6 +33,7 @@ namespace fs = std::experimental::filesystem;
 
 namespace {
 struct {
+    bool bytecode{true};
     bool compress{true};
     std::string dest{"." PATH_SEP_STR "assets.pak"};
     bool overwrite{false};
@@ -102,6 +104,8 @@ void parse_command_line(int argc, char ** argv) {
             }
         } else if (arg == "--continue") {
             settings.quit_on_error = false;
+        } else if (arg == "--no-bytecode") {
+            settings.bytecode = false;
         } else if (arg == "--no-compress") {
             settings.compress = false;
         } else if (arg[0] == '-') {
@@ -186,6 +190,59 @@ void write_asset(unsigned long index, std::ofstream & ofs, const std::string & n
     }
 }
 
+bool is_script(const std::string & name) {
+    std::string filename{name};
+    std::transform(filename.begin(), filename.end(), filename.begin(), ::tolower);
+    return filename.length() > 3 && filename.compare(filename.length() - 3, 3, ".js") == 0;
+}
+
+void write_script_bytecode(unsigned long index, std::ofstream & ofs, const std::string & name,
+                           std::vector<Critterbits::AssetPack::CB_AssetDictEntry> & entries) {
+#ifdef DUK_USE_BYTECODE_DUMP_SUPPORT
+    std::ifstream ifs{settings.src + name, std::ifstream::binary};
+    if (!ifs.good()) {
+        LogError("Script " + name + " could not be opened for reading");
+        return;
+    }
+    std::string source{(std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>()};
+
+    duk_context * context = duk_create_heap_default();
+    if (context == nullptr) {
+        LogError("Unable to create duktape heap to compile " + name);
+        return;
+    }
+    // compile as global code, the same way the engine evaluates script source
+    duk_push_string(context, name.c_str());
+    if (duk_pcompile_lstring_filename(context, 0, source.c_str(), source.length()) != 0) {
+        LogError("Unable to compile script " + name + ": " + std::string{duk_safe_to_string(context, -1)});
+    } else {
+        duk_dump_function(context);
+        duk_size_t bytecode_size = 0;
+        const char * bytecode = static_cast<const char *>(duk_get_buffer(context, -1, &bytecode_size));
+
+        Critterbits::AssetPack::CB_AssetDictEntry dict;
+        dict.index = index;
+        std::string bytecode_name{name + CB_ASSETPACK_BYTECODE_SUFFIX};
+        if (bytecode_name.length() >= CB_ASSETPACK_MAX_NAME_SIZE) {
+            LogError("Asset name " + bytecode_name + " is too long! (max " +
+                     std::to_string(CB_ASSETPACK_MAX_NAME_SIZE) + " chars.)");
+        }
+        std::strncpy(dict.name, bytecode_name.c_str(), CB_ASSETPACK_MAX_NAME_SIZE);
+        dict.pos = ofs.tellp();
+        dict.length = bytecode_size;
+        dict.format = CB_ASSETPACK_FORMAT_SCRIPT_BYTECODE;
+        dict.format_version = DUK_VERSION;
+        dict.checksum = Critterbits::AssetPack::Checksum(bytecode, bytecode_size);
+        // bytecode is always stored uncompressed so the engine can hand it straight to duk_load_function
+        LogInfo("[" + std::to_string(index + 1) + "] Writing script bytecode " + bytecode_name + " (" +
+                std::to_string(bytecode_size) + " bytes)");
+        ofs.write(bytecode, bytecode_size);
+        entries.push_back(dict);
+    }
+    duk_destroy_heap(context);
+#endif
+}
+
 void write_header(std::ofstream & ofs, const Critterbits::AssetPack::CB_AssetPackHeader & header) {
     Critterbits::AssetPack::CB_AssetPackHeader header_to_write{header};
     header_to_write.flags = htonl(header_to_write.flags);
@@ -201,6 +258,9 @@ void write_dict_entry(std::ofstream & ofs, const Critterbits::AssetPack::CB_Asse
     entry_to_write.index = htonl(entry_to_write.index);
     entry_to_write.pos = htonl(entry_to_write.pos);
     entry_to_write.length = htonl(entry_to_write.length);
+    entry_to_write.format = htonl(entry_to_write.format);
+    entry_to_write.format_version = htonl(entry_to_write.format_version);
+    entry_to_write.checksum = htonl(entry_to_write.checksum);
 
     ofs.write(reinterpret_cast<const char *>(&entry_to_write), sizeof(Critterbits::AssetPack::CB_AssetDictEntry));
 }
@@ -364,6 +424,9 @@ int main(int argc, char ** argv) {
     unsigned long asset_index = 0L;
     for (auto & asset_name : asset_names) {
         write_asset(asset_index++, pack, asset_name, dict);
+        if (settings.bytecode && is_script(asset_name)) {
+            write_script_bytecode(asset_index++, pack, asset_name, dict);
+        }
     }
 
     // write asset table
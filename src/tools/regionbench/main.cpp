@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <cb/critterbits.hpp>
+
+/*
+ * Compares RectRegionCombiner against the pairwise merge it replaced on synthetic collide layers. Each map is
+ * combined by both, both results are checked against the tile grid, and the timings are printed.
+ *
+ * usage: regionbench [map_size] [seed]
+ */
+
+using namespace Critterbits;
+
+#define CB_REGIONBENCH_TILE_SIZE 16
+
+namespace {
+typedef std::vector<bool> TileGrid;
+
+struct MapResult {
+    size_t regions;
+    double ms;
+    bool exact;
+};
+
+/*
+ * The old brute force merge, kept as it was apart from walking the vector by index: the original appended to the
+ * vector it was iterating, which was only safe until the reserved capacity ran out. Each pass still only visits the
+ * rects that existed when it started, the same as the original did while it stayed within capacity.
+ */
+void CombinePairwise(std::vector<CB_Rect> & regions) {
+    int combines;
+    regions.erase(std::unique(regions.begin(), regions.end(),
+                              [](const CB_Rect & rect1, const CB_Rect & rect2) {
+                                  return rect1 == rect2 || rect1.inside(rect2);
+                              }),
+                  regions.end());
+    regions.reserve(regions.size() * 2);
+    do {
+        combines = 0;
+        size_t count = regions.size();
+        for (size_t i = 0; i < count; i++) {
+            if (regions[i].empty())
+                continue;
+            for (size_t j = 0; j < count; j++) {
+                if (regions[i].empty() || regions[j].empty())
+                    continue;
+                CB_Rect rect1 = regions[i], rect2 = regions[j];
+                if (rect1.y == rect2.y && rect1.h == rect2.h &&
+                    (rect1.x == rect2.right() || rect1.right() == rect2.x)) {
+                    regions.emplace_back(std::min(rect1.x, rect2.x), rect1.y, rect1.w + rect2.w, rect1.h);
+                    regions[i] = CB_Rect{rect1.x, rect1.y, 0, 0};
+                    regions[j] = CB_Rect{rect2.x, rect2.y, 0, 0};
+                    combines++;
+                } else if (rect1.x == rect2.x && rect1.w == rect2.w &&
+                           (rect1.y == rect2.bottom() || rect1.bottom() == rect2.y)) {
+                    regions.emplace_back(rect1.x, std::min(rect1.y, rect2.y), rect1.w, rect1.h + rect2.h);
+                    regions[i] = CB_Rect{rect1.x, rect1.y, 0, 0};
+                    regions[j] = CB_Rect{rect2.x, rect2.y, 0, 0};
+                    combines++;
+                }
+            }
+        }
+    } while (combines > 0);
+    regions.erase(
+        std::remove_if(regions.begin(), regions.end(), [](const CB_Rect & rect) { return rect.empty(); }),
+        regions.end());
+}
+
+TileGrid RandomTiles(int size, std::mt19937 & rng) {
+    // worst case: unconnected noise at 50% fill
+    TileGrid tiles(size * size);
+    std::bernoulli_distribution solid(0.5);
+    for (size_t i = 0; i < tiles.size(); i++) {
+        tiles[i] = solid(rng);
+    }
+    return tiles;
+}
+
+TileGrid CaveTiles(int size, std::mt19937 & rng) {
+    // noise smoothed by a few cellular automaton steps, like a generated cave
+    TileGrid tiles = RandomTiles(size, rng);
+    for (int step = 0; step < 4; step++) {
+        TileGrid next(tiles.size());
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                int neighbours = 0;
+                for (int dy = -1; dy <= 1; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        int nx = x + dx, ny = y + dy;
+                        if (nx < 0 || ny < 0 || nx >= size || ny >= size || tiles[ny * size + nx]) {
+                            neighbours++;
+                        }
+                    }
+                }
+                next[y * size + x] = neighbours >= 5;
+            }
+        }
+        tiles.swap(next);
+    }
+    return tiles;
+}
+
+TileGrid RoomTiles(int size, std::mt19937 & rng) {
+    // one-tile walls around scattered rooms inside a solid border, like a hand made dungeon's collide layer
+    TileGrid tiles(size * size);
+    std::uniform_int_distribution<int> room_size(4, 24);
+    std::uniform_int_distribution<int> room_pos(0, size - 1);
+    for (int i = 0; i < size * size / 150; i++) {
+        int x1 = room_pos(rng), y1 = room_pos(rng);
+        int x2 = std::min(size - 1, x1 + room_size(rng)), y2 = std::min(size - 1, y1 + room_size(rng));
+        for (int x = x1; x <= x2; x++) {
+            tiles[y1 * size + x] = tiles[y2 * size + x] = true;
+        }
+        for (int y = y1; y <= y2; y++) {
+            tiles[y * size + x1] = tiles[y * size + x2] = true;
+        }
+    }
+    for (int i = 0; i < size; i++) {
+        tiles[i] = tiles[(size - 1) * size + i] = tiles[i * size] = tiles[i * size + size - 1] = true;
+    }
+    return tiles;
+}
+
+std::vector<CB_Rect> GetTileRects(const TileGrid & tiles, int size) {
+    // the same row-major order Tilemap feeds the combiner in
+    std::vector<CB_Rect> rects;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            if (tiles[y * size + x]) {
+                rects.emplace_back(x * CB_REGIONBENCH_TILE_SIZE, y * CB_REGIONBENCH_TILE_SIZE,
+                                   CB_REGIONBENCH_TILE_SIZE, CB_REGIONBENCH_TILE_SIZE);
+            }
+        }
+    }
+    return rects;
+}
+
+bool CoversExactly(const std::vector<CB_Rect> & regions, const TileGrid & tiles, int size) {
+    // every solid tile covered exactly once, nothing else covered
+    std::vector<int> coverage(tiles.size(), 0);
+    for (auto & region : regions) {
+        if (region.x < 0 || region.y < 0 || region.w <= 0 || region.h <= 0 ||
+            region.x % CB_REGIONBENCH_TILE_SIZE != 0 || region.y % CB_REGIONBENCH_TILE_SIZE != 0 ||
+            region.w % CB_REGIONBENCH_TILE_SIZE != 0 || region.h % CB_REGIONBENCH_TILE_SIZE != 0 ||
+            region.right() > size * CB_REGIONBENCH_TILE_SIZE || region.bottom() > size * CB_REGIONBENCH_TILE_SIZE) {
+            return false;
+        }
+        for (int y = region.y / CB_REGIONBENCH_TILE_SIZE; y < region.bottom() / CB_REGIONBENCH_TILE_SIZE; y++) {
+            for (int x = region.x / CB_REGIONBENCH_TILE_SIZE; x < region.right() / CB_REGIONBENCH_TILE_SIZE; x++) {
+                coverage[y * size + x]++;
+            }
+        }
+    }
+    for (size_t i = 0; i < tiles.size(); i++) {
+        if (coverage[i] != (tiles[i] ? 1 : 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename F>
+MapResult RunCombiner(const TileGrid & tiles, int size, F combine) {
+    std::vector<CB_Rect> regions = GetTileRects(tiles, size);
+    auto start = std::chrono::steady_clock::now();
+    combine(regions);
+    auto end = std::chrono::steady_clock::now();
+    return MapResult{regions.size(), std::chrono::duration<double, std::milli>(end - start).count(),
+                     CoversExactly(regions, tiles, size)};
+}
+
+void PrintResult(const std::string & name, const MapResult & result) {
+    std::cout << "  " << std::left << std::setw(10) << name << std::right << std::setw(8) << result.regions
+              << " regions " << std::fixed << std::setprecision(2) << std::setw(12) << result.ms << " ms  "
+              << (result.exact ? "exact" : "MISMATCH") << std::endl;
+}
+}
+
+int main(int argc, char ** argv) {
+    int size = argc > 1 ? std::atoi(argv[1]) : 300;
+    unsigned int seed = argc > 2 ? static_cast<unsigned int>(std::strtoul(argv[2], nullptr, 10)) : 1;
+    if (size < 1) {
+        std::cerr << "usage: " << argv[0] << " [map_size] [seed]" << std::endl;
+        return 1;
+    }
+
+    struct {
+        const char * name;
+        TileGrid (*generate)(int, std::mt19937 &);
+    } maps[] = {{"random", RandomTiles}, {"cave", CaveTiles}, {"rooms", RoomTiles}};
+
+    bool all_exact = true;
+    for (auto & map : maps) {
+        std::mt19937 rng{seed};
+        TileGrid tiles = map.generate(size, rng);
+        size_t solid = std::count(tiles.begin(), tiles.end(), true);
+        std::cout << map.name << " " << size << "x" << size << ", " << solid << " collide tiles" << std::endl;
+
+        MapResult pairwise = RunCombiner(tiles, size, CombinePairwise);
+        MapResult scanline = RunCombiner(tiles, size, [](std::vector<CB_Rect> & regions) {
+            RectRegionCombiner combiner;
+            combiner.regions.swap(regions);
+            combiner.Combine();
+            regions.swap(combiner.regions);
+        });
+        PrintResult("pairwise", pairwise);
+        PrintResult("scanline", scanline);
+        all_exact = all_exact && pairwise.exact && scanline.exact;
+    }
+    return all_exact ? 0 : 1;
+}
\ No newline at end of file